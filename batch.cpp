@@ -0,0 +1,470 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <immintrin.h>
+
+#include "column.h"
+#include "fn.h"
+#include "kernels.h"
+#include "simd.h"
+
+
+namespace {
+
+// candidates are read ahead by this count to hide the cache miss on their bytes
+constexpr size_t PREFETCH_DISTANCE = 8;
+
+void prefetch(std::span<const std::string_view> candidates, size_t i) noexcept {
+    if (i + PREFETCH_DISTANCE < candidates.size()) {
+        _mm_prefetch(candidates[i + PREFETCH_DISTANCE].data(), _MM_HINT_T0);
+    }
+}
+
+// rows of a column are contiguous, this keeps the stream ahead of the hardware prefetcher at row starts
+void prefetch(StringColumn const& column, size_t i) noexcept {
+    if (i + PREFETCH_DISTANCE < column.size()) {
+        _mm_prefetch(column.row(i + PREFETCH_DISTANCE), _MM_HINT_T0);
+    }
+}
+
+// Collects verdicts into 64-bit words of the output bitmap
+class BitmapWriter {
+public:
+    explicit BitmapWriter(std::span<uint64_t> out) noexcept
+        : m_out(out) {
+    }
+
+    void push(size_t i, bool bit) noexcept {
+        m_word |= uint64_t{bit} << (i % 64);
+        if (i % 64 == 63) {
+            flush(i);
+        }
+    }
+
+    size_t finish(size_t size) noexcept {
+        if (size % 64 != 0) {
+            flush(size - 1);
+        }
+        return m_count;
+    }
+
+private:
+    void flush(size_t i) noexcept {
+        m_out[i / 64] = m_word;
+        m_count += std::popcount(m_word);
+        m_word = 0;
+    }
+
+    std::span<uint64_t> m_out;
+    uint64_t m_word = 0;
+    size_t m_count = 0;
+};
+
+// oneChange() through the size-specialized kernels of a level
+template <typename SameFn, typename DiffFn>
+bool oneChangeBySize(std::string_view lhs, std::string_view rhs, SameFn same, DiffFn diff) noexcept {
+    if (lhs.size() == rhs.size()) {
+        return same(lhs, rhs);
+    } else if (lhs.size() == rhs.size() + 1) {
+        return diff(lhs, rhs);
+    } else if (lhs.size() + 1 == rhs.size()) {
+        return diff(rhs, lhs);
+    }
+    return false;
+}
+
+// Rows: std::span<const std::string_view> or StringColumn
+template <typename Rows, typename SameFn, typename DiffFn>
+size_t batchGeneric(std::string_view query, Rows const& candidates,
+                    std::span<uint64_t> out, SameFn same, DiffFn diff) noexcept {
+    BitmapWriter writer(out);
+    for (size_t i = 0; i != candidates.size(); ++i) {
+        prefetch(candidates, i);
+        writer.push(i, oneChangeBySize(candidates[i], query, same, diff));
+    }
+    return writer.finish(candidates.size());
+}
+
+constexpr size_t SHORT_GROUP = 32;
+
+template <typename SameFn, typename DiffFn>
+size_t shortBatchGeneric(std::span<const std::string_view> lhs, std::span<const std::string_view> rhs,
+                         std::span<uint32_t> out, SameFn same, DiffFn diff) noexcept {
+    size_t count = 0;
+    for (size_t group = 0; group * SHORT_GROUP < lhs.size(); ++group) {
+        uint32_t word = 0;
+        const auto end = std::min(lhs.size(), (group + 1) * SHORT_GROUP);
+        for (size_t i = group * SHORT_GROUP; i != end; ++i) {
+            word |= uint32_t{oneChangeBySize(lhs[i], rhs[i], same, diff)} << (i % SHORT_GROUP);
+        }
+        out[group] = word;
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+template <typename SameFn, typename DiffFn>
+size_t columnsGeneric(StringColumn const& lhs, StringColumn const& rhs, std::span<uint64_t> out,
+                      SameFn same, DiffFn diff) noexcept {
+    BitmapWriter writer(out);
+    for (size_t i = 0; i != lhs.size(); ++i) {
+        prefetch(lhs, i);
+        prefetch(rhs, i);
+        writer.push(i, oneChangeBySize(lhs[i], rhs[i], same, diff));
+    }
+    return writer.finish(lhs.size());
+}
+
+ONECHANGE_TARGET_AVX2_BEGIN
+// page edge: the bytes of a string under 32 bytes copied to the stack
+[[gnu::cold, gnu::noinline]] __m256i stagedHead(std::string_view str) noexcept {
+    char head[32] = {};
+    if (!str.empty()) {
+        memcpy(head, str.data(), str.size());
+    }
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(head));
+}
+
+// 32 bytes from the start of str, the bytes past its end are arbitrary
+inline __m256i loadHead(std::string_view str) noexcept {
+    const auto pageOffset = reinterpret_cast<uintptr_t>(str.data()) & (ONECHANGE_PAGE_SIZE - 1);
+    if (str.size() >= 32 || (pageOffset <= ONECHANGE_PAGE_SIZE - 32 && str.size() != 0)) [[likely]] {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str.data()));
+    }
+    return stagedHead(str);
+}
+
+// bit c is set if byte c of a and b differ, for c < size
+inline uint32_t headErrors(__m256i a, __m256i b, size_t size) noexcept {
+    const auto errors = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+    return _bzhi_u32(errors, static_cast<uint32_t>(std::min<size_t>(size, 32)));
+}
+
+// longer = shorter with one extra symbol, shorter.size() >= 32, direct and shifted are the errors of
+// longer[c] and longer[c + 1] against shorter[c] in the first 32 bytes: the kernel goes on after them
+inline bool oneExtraAfterHead(std::string_view longer, std::string_view shorter,
+                              uint32_t direct, uint32_t shifted) noexcept {
+    if (direct == 0) {
+        return oneChangeDiffSizeFastAVX(longer.substr(32), shorter.substr(32));
+    }
+    // the extra symbol is at the first error, the rest is shifted by one
+    return (shifted >> std::countr_zero(direct)) == 0 && longer.substr(33) == shorter.substr(32);
+}
+
+template <typename Rows>
+size_t batchAVX2(std::string_view query, Rows const& candidates,
+                 std::span<uint64_t> out) noexcept {
+    const auto size = query.size();
+    // query[0, 32) and query[1, 33) stay in registers for the whole batch
+    char padded[33] = {};
+    if (size != 0) {
+        memcpy(padded, query.data(), std::min<size_t>(size, 33));
+    }
+    const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(padded));
+    const __m256i shiftedHead = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(padded + 1));
+
+    // the longer string has an extra symbol at the first direct error, then all shifted errors are before it
+    const auto fnOneExtra = [](uint32_t direct, uint32_t shifted) {
+        return direct == 0 || (shifted >> std::countr_zero(direct)) == 0;
+    };
+
+    BitmapWriter writer(out);
+    for (size_t i = 0; i != candidates.size(); ++i) {
+        prefetch(candidates, i);
+        const auto candidate = candidates[i];
+        bool result = false;
+        if (candidate.size() == size) {
+            const auto errors = std::popcount(headErrors(loadHead(candidate), head, size));
+            if (size <= 32 || errors > 1) {
+                result = errors <= 1;
+            } else {
+                // the kernel starts after the head block
+                result = errors == 0 ? oneChangeSameSizeFastAVX(query.substr(32), candidate.substr(32))
+                                     : query.substr(32) == candidate.substr(32);
+            }
+        } else if (candidate.size() == size + 1) {
+            const auto direct = headErrors(loadHead(candidate), head, size);
+            const auto shifted = headErrors(loadHead(candidate.substr(1)), head, size);
+            result = size <= 32 ? fnOneExtra(direct, shifted) : oneExtraAfterHead(candidate, query, direct, shifted);
+        } else if (candidate.size() + 1 == size) {
+            const __m256i chunk = loadHead(candidate);
+            const auto direct = headErrors(chunk, head, candidate.size());
+            const auto shifted = headErrors(chunk, shiftedHead, candidate.size());
+            result = candidate.size() <= 32 ? fnOneExtra(direct, shifted)
+                                            : oneExtraAfterHead(query, candidate, direct, shifted);
+        }
+        writer.push(i, result);
+    }
+    return writer.finish(candidates.size());
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX2_BEGIN
+// page edge: the bytes of a short string copied to the stack
+[[gnu::cold, gnu::noinline]] __m128i stagedRow(std::string_view str) noexcept {
+    char row[16] = {};
+    if (!str.empty()) {
+        memcpy(row, str.data(), str.size());
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+}
+
+// 16 bytes from the start of str, the bytes past its end are arbitrary
+inline __m128i loadRow(std::string_view str) noexcept {
+    const auto pageOffset = reinterpret_cast<uintptr_t>(str.data()) & (ONECHANGE_PAGE_SIZE - 1);
+    // an empty view can have no data at all
+    if (str.size() >= 16 || (pageOffset <= ONECHANGE_PAGE_SIZE - 16 && str.size() != 0)) [[likely]] {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data()));
+    }
+    return stagedRow(str);
+}
+
+template <int BYTES>
+__m256i unpackLo(__m256i a, __m256i b) noexcept {
+    if constexpr (BYTES == 1) {
+        return _mm256_unpacklo_epi8(a, b);
+    } else if constexpr (BYTES == 2) {
+        return _mm256_unpacklo_epi16(a, b);
+    } else if constexpr (BYTES == 4) {
+        return _mm256_unpacklo_epi32(a, b);
+    } else {
+        return _mm256_unpacklo_epi64(a, b);
+    }
+}
+
+template <int BYTES>
+__m256i unpackHi(__m256i a, __m256i b) noexcept {
+    if constexpr (BYTES == 1) {
+        return _mm256_unpackhi_epi8(a, b);
+    } else if constexpr (BYTES == 2) {
+        return _mm256_unpackhi_epi16(a, b);
+    } else if constexpr (BYTES == 4) {
+        return _mm256_unpackhi_epi32(a, b);
+    } else {
+        return _mm256_unpackhi_epi64(a, b);
+    }
+}
+
+template <int BYTES>
+void transposeRound(__m256i (&x)[16]) noexcept {
+    __m256i y[16];
+    for (int k = 0; k != 8; ++k) {
+        y[k] = unpackLo<BYTES>(x[2 * k], x[2 * k + 1]);
+        y[k + 8] = unpackHi<BYTES>(x[2 * k], x[2 * k + 1]);
+    }
+    std::copy(std::begin(y), std::end(y), x);
+}
+
+// Rows of 16 bytes in each 128-bit lane to columns: byte c of x[p] goes to byte p of x[bit-reversed c]
+void transpose16(__m256i (&x)[16]) noexcept {
+    transposeRound<1>(x);
+    transposeRound<2>(x);
+    transposeRound<4>(x);
+    transposeRound<8>(x);
+}
+
+constexpr int column(int c) noexcept {
+    return ((c & 1) << 3) | ((c & 2) << 1) | ((c & 4) >> 1) | ((c & 8) >> 3);
+}
+
+// 32 pairs, bit i is the verdict of pair i. Strings of at most ONECHANGE_SHORT_BATCH_SIZE bytes are transposed: byte i
+// of a column register is pair i (pairs 16..31 in the high lane), so each compare is of one position in all pairs.
+// Same size pairs fail on a second error, lhs longer ones on lhs[c + 1] != rhs[c] after an error at or before c.
+uint32_t shortGroupAVX2(std::string_view const* lhs, std::string_view const* rhs) noexcept {
+    constexpr auto MAX_SIZE = ONECHANGE_SHORT_BATCH_SIZE + 1; // sizes above it are all "long"
+    __m256i l[16];
+    __m256i r[16];
+    alignas(32) uint8_t lhsSizes[SHORT_GROUP];
+    alignas(32) uint8_t rhsSizes[SHORT_GROUP];
+#pragma GCC unroll 16
+    for (size_t p = 0; p != 16; ++p) {
+        l[p] = _mm256_set_m128i(loadRow(lhs[p + 16]), loadRow(lhs[p]));
+        r[p] = _mm256_set_m128i(loadRow(rhs[p + 16]), loadRow(rhs[p]));
+        for (size_t q : {p, p + 16}) {
+            lhsSizes[q] = static_cast<uint8_t>(std::min(lhs[q].size(), MAX_SIZE));
+            rhsSizes[q] = static_cast<uint8_t>(std::min(rhs[q].size(), MAX_SIZE));
+        }
+    }
+    transpose16(l);
+    transpose16(r);
+
+    const __m256i lhsSize = _mm256_load_si256(reinterpret_cast<const __m256i*>(lhsSizes));
+    const __m256i rhsSize = _mm256_load_si256(reinterpret_cast<const __m256i*>(rhsSizes));
+    const __m256i minSize = _mm256_min_epu8(lhsSize, rhsSize);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i anyError = zero;
+    __m256i sameFail = zero;
+    __m256i lhsLongerFail = zero;
+    __m256i rhsLongerFail = zero;
+#pragma GCC unroll 16
+    for (int c = 0; c != 16; ++c) {
+        const __m256i valid = _mm256_cmpgt_epi8(minSize, _mm256_set1_epi8(static_cast<char>(c)));
+        const __m256i lhsNext = c + 1 != 16 ? l[column(c + 1)] : zero;
+        const __m256i rhsNext = c + 1 != 16 ? r[column(c + 1)] : zero;
+        const __m256i error = _mm256_andnot_si256(_mm256_cmpeq_epi8(l[column(c)], r[column(c)]), valid);
+        sameFail = _mm256_or_si256(sameFail, _mm256_and_si256(error, anyError));
+        anyError = _mm256_or_si256(anyError, error);
+        const __m256i lhsShifted = _mm256_andnot_si256(_mm256_cmpeq_epi8(lhsNext, r[column(c)]), valid);
+        const __m256i rhsShifted = _mm256_andnot_si256(_mm256_cmpeq_epi8(l[column(c)], rhsNext), valid);
+        lhsLongerFail = _mm256_or_si256(lhsLongerFail, _mm256_and_si256(lhsShifted, anyError));
+        rhsLongerFail = _mm256_or_si256(rhsLongerFail, _mm256_and_si256(rhsShifted, anyError));
+    }
+
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i same = _mm256_andnot_si256(sameFail, _mm256_cmpeq_epi8(lhsSize, rhsSize));
+    const __m256i lhsLonger = _mm256_andnot_si256(lhsLongerFail,
+                                                  _mm256_cmpeq_epi8(lhsSize, _mm256_add_epi8(rhsSize, one)));
+    const __m256i rhsLonger = _mm256_andnot_si256(rhsLongerFail,
+                                                  _mm256_cmpeq_epi8(rhsSize, _mm256_add_epi8(lhsSize, one)));
+    auto result = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(same, _mm256_or_si256(lhsLonger, rhsLonger))));
+
+    // pairs with a longer string take the per-pair kernel
+    const __m256i longPair = _mm256_cmpeq_epi8(_mm256_max_epu8(lhsSize, rhsSize), _mm256_set1_epi8(MAX_SIZE));
+    for (auto longPairs = static_cast<uint32_t>(_mm256_movemask_epi8(longPair)); longPairs != 0;
+         longPairs &= longPairs - 1) {
+        const auto i = std::countr_zero(longPairs);
+        const bool verdict = oneChangeBySize(lhs[i], rhs[i], oneChangeSameSizeFastAVX, oneChangeDiffSizeFastAVX);
+        result = (result & ~(1u << i)) | (uint32_t{verdict} << i);
+    }
+    return result;
+}
+
+size_t shortBatchAVX2(std::span<const std::string_view> lhs, std::span<const std::string_view> rhs,
+                      std::span<uint32_t> out) noexcept {
+    size_t count = 0;
+    size_t group = 0;
+    for (; (group + 1) * SHORT_GROUP <= lhs.size(); ++group) {
+        out[group] = shortGroupAVX2(lhs.data() + group * SHORT_GROUP, rhs.data() + group * SHORT_GROUP);
+        count += std::popcount(out[group]);
+    }
+    if (const auto rest = lhs.size() - group * SHORT_GROUP; rest != 0) {
+        // the last pairs padded with empty ones
+        std::string_view lhsRest[SHORT_GROUP];
+        std::string_view rhsRest[SHORT_GROUP];
+        std::copy_n(lhs.data() + group * SHORT_GROUP, rest, lhsRest);
+        std::copy_n(rhs.data() + group * SHORT_GROUP, rest, rhsRest);
+        out[group] = shortGroupAVX2(lhsRest, rhsRest) & ((1u << rest) - 1);
+        count += std::popcount(out[group]);
+    }
+    return count;
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+template <typename Rows>
+size_t batchAVX512(std::string_view query, Rows const& candidates,
+                   std::span<uint64_t> out) noexcept {
+    const auto size = query.size();
+    const __mmask64 headMask = _bzhi_u64(~0ull, std::min<size_t>(size, 64));
+    const __mmask64 shiftedMask = _bzhi_u64(~0ull, std::min<size_t>(size - (size != 0), 64));
+    // query[0, 64) and query[1, 65) stay in registers for the whole batch
+    const __m512i head = _mm512_maskz_loadu_epi8(headMask, query.data());
+    const __m512i shiftedHead = _mm512_maskz_loadu_epi8(shiftedMask, query.data() + (size != 0));
+
+    // the longer string has an extra symbol at the first direct error, then all shifted errors are before it
+    const auto fnOneExtra = [](__mmask64 direct, __mmask64 shifted) {
+        return direct == 0 || (shifted >> std::countr_zero(direct)) == 0;
+    };
+
+    BitmapWriter writer(out);
+    for (size_t i = 0; i != candidates.size(); ++i) {
+        prefetch(candidates, i);
+        const auto candidate = candidates[i];
+        bool result = false;
+        if (candidate.size() == size) {
+            if (size <= 64) {
+                __m512i chunk = _mm512_maskz_loadu_epi8(headMask, candidate.data());
+                result = std::popcount(_mm512_mask_cmpneq_epi8_mask(headMask, chunk, head)) <= 1;
+            } else {
+                __m512i chunk = _mm512_loadu_si512(candidate.data());
+                result = std::popcount(_mm512_cmpneq_epi8_mask(chunk, head)) <= 1
+                        && oneChangeSameSizeFastAVX512(query, candidate);
+            }
+        } else if (candidate.size() == size + 1) {
+            if (size <= 64) {
+                __m512i chunk = _mm512_maskz_loadu_epi8(headMask, candidate.data());
+                __m512i shifted = _mm512_maskz_loadu_epi8(headMask, candidate.data() + 1);
+                result = fnOneExtra(_mm512_mask_cmpneq_epi8_mask(headMask, chunk, head),
+                                    _mm512_mask_cmpneq_epi8_mask(headMask, shifted, head));
+            } else {
+                result = oneChangeDiffSizeFastAVX512(candidate, query);
+            }
+        } else if (candidate.size() + 1 == size) {
+            if (candidate.size() <= 64) {
+                __m512i chunk = _mm512_maskz_loadu_epi8(shiftedMask, candidate.data());
+                result = fnOneExtra(_mm512_mask_cmpneq_epi8_mask(shiftedMask, chunk, head),
+                                    _mm512_mask_cmpneq_epi8_mask(shiftedMask, chunk, shiftedHead));
+            } else {
+                result = oneChangeDiffSizeFastAVX512(query, candidate);
+            }
+        }
+        writer.push(i, result);
+    }
+    return writer.finish(candidates.size());
+}
+ONECHANGE_TARGET_END
+
+}
+
+
+size_t oneChangeBatch(std::string_view query, std::span<const std::string_view> candidates,
+                      std::span<uint64_t> out) noexcept {
+    assert(out.size() * 64 >= candidates.size());
+    switch (oneChangeAutoLevel()) {
+        case SimdLevel::AVX512:
+            return batchAVX512(query, candidates, out);
+        case SimdLevel::AVX2:
+            return batchAVX2(query, candidates, out);
+        case SimdLevel::SSE:
+            return batchGeneric(query, candidates, out, oneChangeSameSizeFast, oneChangeDiffSizeFast);
+        default:
+            return batchGeneric(query, candidates, out, oneChangeSameSizeFastSWAR, oneChangeDiffSizeFastSWAR);
+    }
+}
+
+size_t oneChangeShortBatch(std::span<const std::string_view> lhs, std::span<const std::string_view> rhs,
+                           std::span<uint32_t> out) noexcept {
+    assert(lhs.size() == rhs.size() && out.size() * SHORT_GROUP >= lhs.size());
+    switch (oneChangeAutoLevel()) {
+        case SimdLevel::AVX512:
+        case SimdLevel::AVX2:
+            return shortBatchAVX2(lhs, rhs, out);
+        case SimdLevel::SSE:
+            return shortBatchGeneric(lhs, rhs, out, oneChangeSameSizeFast, oneChangeDiffSizeFast);
+        default:
+            return shortBatchGeneric(lhs, rhs, out, oneChangeSameSizeFastSWAR, oneChangeDiffSizeFastSWAR);
+    }
+}
+
+size_t oneChangeColumn(StringColumn const& lhs, StringColumn const& rhs, std::span<uint64_t> out) noexcept {
+    assert(lhs.size() == rhs.size() && out.size() * 64 >= lhs.size());
+    const bool padded = lhs.padded() && rhs.padded();
+    switch (oneChangeAutoLevel()) {
+        case SimdLevel::AVX512:
+            return columnsGeneric(lhs, rhs, out, oneChangeSameSizeFastAVX512, oneChangeDiffSizeFastAVX512);
+        case SimdLevel::AVX2:
+            return padded ? columnsGeneric(lhs, rhs, out, oneChangeSameSizePaddedAVX, oneChangeDiffSizePaddedAVX)
+                          : columnsGeneric(lhs, rhs, out, oneChangeSameSizeFastAVX, oneChangeDiffSizeFastAVX);
+        case SimdLevel::SSE:
+            return padded ? columnsGeneric(lhs, rhs, out, oneChangeSameSizePadded, oneChangeDiffSizePadded)
+                          : columnsGeneric(lhs, rhs, out, oneChangeSameSizeFast, oneChangeDiffSizeFast);
+        default:
+            return padded ? columnsGeneric(lhs, rhs, out, oneChangeSameSizePaddedSWAR, oneChangeDiffSizePaddedSWAR)
+                          : columnsGeneric(lhs, rhs, out, oneChangeSameSizeFastSWAR, oneChangeDiffSizeFastSWAR);
+    }
+}
+
+size_t oneChangeColumn(StringColumn const& column, std::string_view query, std::span<uint64_t> out) noexcept {
+    assert(out.size() * 64 >= column.size());
+    switch (oneChangeAutoLevel()) {
+        case SimdLevel::AVX512:
+            return batchAVX512(query, column, out);
+        case SimdLevel::AVX2:
+            return batchAVX2(query, column, out);
+        case SimdLevel::SSE:
+            return batchGeneric(query, column, out, oneChangeSameSizeFast, oneChangeDiffSizeFast);
+        default:
+            return batchGeneric(query, column, out, oneChangeSameSizeFastSWAR, oneChangeDiffSizeFastSWAR);
+    }
+}
@@ -3,8 +3,25 @@
 #include <array>
 #include <stdexcept>
 #include <cstring>
+#include <cctype>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
 
+#include "column.h"
 #include "fn.h"
+#include "index.h"
+#include "join.h"
+#include "latency.h"
+#include "matcher.h"
+#include "perf.h"
+#include "pool.h"
+#include "search.h"
+#include "workload.h"
 
 using sv = std::string_view;
 using fn = bool(*)(sv, sv);
@@ -56,7 +73,7 @@ std::string diff4(std::string str) {
     std::string result = str.substr(0, i);
     result.push_back(gen1());
     result.append(str.data() + i, str.size() - i);
-    return str;
+    return result;
 }
 
 std::string diff5(std::string str) {
@@ -71,13 +88,87 @@ std::string diff6(std::string str) {
 
 static constexpr size_t DIFF_COUNT = 6;
 
+static bool oneChangeDetailBool(sv lhs, sv rhs) {
+    return oneChangeDetail(lhs, rhs).kind != OneChangeKind::None;
+}
+
+static bool skipUnsupported(benchmark::State& state, fn fn) {
+    for (auto const& kernel : FAST_KERNELS) {
+        if (kernel.fn == fn && detectSimdLevel() < kernel.level) {
+            state.SkipWithError("The SIMD level is not supported");
+            return true;
+        }
+    }
+    return false;
+}
+
+// ONECHANGE_PERF=1 reads perf_event counters around the benchmark loop: create it right before the loop and
+// call report() after SetBytesProcessed/SetItemsProcessed. Values are per call (an item, or an iteration if
+// there are no items) and per KB processed. Without perf (VM, perf_event_paranoid) it warns once and only
+// the time is reported.
+class PerfScope {
+public:
+    explicit PerfScope(benchmark::State& state) : m_state(state) {
+        if (!perfCountersRequested()) {
+            return;
+        }
+        m_counters = std::make_unique<PerfCounters>();
+        if (!m_counters->available()) {
+            static bool warned = false;
+            if (!std::exchange(warned, true)) {
+                std::fprintf(stderr, "perf_event counters are unavailable (%s), reporting time only\n",
+                             m_counters->error().c_str());
+            }
+            m_counters.reset();
+            return;
+        }
+        m_counters->start();
+    }
+
+    void report() {
+        if (!m_counters) {
+            return;
+        }
+        const auto values = m_counters->stop();
+        m_counters.reset();
+
+        const auto items = m_state.items_processed();
+        const auto calls = static_cast<double>(items > 0 ? items : m_state.iterations());
+        const auto kb = static_cast<double>(m_state.bytes_processed()) / 1024;
+        const auto set = [&](const char* name, PerfCounters::Event event, double per) {
+            if (values.valid[event] && per > 0) {
+                m_state.counters[name] = values.count[event] / per;
+            }
+        };
+        set("cycles/call", PerfCounters::Cycles, calls);
+        set("instructions/call", PerfCounters::Instructions, calls);
+        set("branchMisses/call", PerfCounters::BranchMisses, calls);
+        set("L1DMisses/KB", PerfCounters::L1DMisses, kb);
+        set("LLCMisses/KB", PerfCounters::LLCMisses, kb);
+        set("cycles/B", PerfCounters::Cycles, kb * 1024);
+        if (values.valid[PerfCounters::Cycles] && values.valid[PerfCounters::Instructions]) {
+            set("IPC", PerfCounters::Instructions, values.count[PerfCounters::Cycles]);
+        }
+    }
+
+private:
+    benchmark::State& m_state;
+    std::unique_ptr<PerfCounters> m_counters;
+};
+
 static void BM_eq(benchmark::State& state, fn fn, std::string const& challenge) {
+    if (skipUnsupported(state, fn)) {
+        return;
+    }
+
+    PerfScope perf(state);
     for (auto _ : state) {
         (fn(challenge, challenge));
     }
 
     state.SetBytesProcessed(static_cast<int64_t>(2 * challenge.size() * state.iterations()));
     state.SetItemsProcessed(state.iterations());
+    perf.report();
 
     if (fn(challenge, challenge) != oneChangeSlow(challenge, challenge)) {
         state.SkipWithError("Check failed (EQ)");
@@ -86,12 +177,17 @@ static void BM_eq(benchmark::State& state, fn fn, std::string const& challenge)
 
 using DiffFn = std::string(*)(std::string);
 static void BM_diff(benchmark::State& state, fn fn, std::string const& challenge) {
+    if (skipUnsupported(state, fn)) {
+        return;
+    }
+
     auto diffList = std::array<DiffFn, DIFF_COUNT>{diff1, diff2, diff3, diff4, diff5, diff6};
     std::array<std::string, DIFF_COUNT> rhsList;
     for (auto i = 0; i != DIFF_COUNT; ++i) {
         rhsList[i] = diffList[i](challenge);
     }
 
+    PerfScope perf(state);
     for (auto _ : state) {
         for (auto const& rhs : rhsList) {
             (fn(challenge, rhs));
@@ -104,6 +200,7 @@ static void BM_diff(benchmark::State& state, fn fn, std::string const& challenge
     }
     state.SetBytesProcessed(bytes * state.iterations());
     state.SetItemsProcessed(state.iterations() * DIFF_COUNT);
+    perf.report();
 
     for (auto const& rhs : rhsList) {
         if (fn(challenge, rhs) != oneChangeSlow(challenge, rhs)) {
@@ -112,6 +209,488 @@ static void BM_diff(benchmark::State& state, fn fn, std::string const& challenge
     }
 }
 
+std::string withEdits(std::string str, unsigned edits) {
+    for (unsigned i = 0; i != edits; ++i) {
+        const auto pos = (i + 1) * str.size() / (edits + 1);
+        switch (i % 3) {
+            case 0: changeSymbol(str[pos]); break;
+            case 1: str.insert(pos, 1, gen1()); break;
+            default: str.erase(pos, 1);
+        }
+    }
+    return str;
+}
+
+static constexpr unsigned MAX_EDITS = 4;
+
+static void BM_distance(benchmark::State& state, unsigned k, std::string const& challenge) {
+    std::array<std::string, MAX_EDITS + 1> rhsList;
+    for (unsigned i = 0; i != rhsList.size(); ++i) {
+        rhsList[i] = withEdits(challenge, i);
+    }
+
+    for (auto _ : state) {
+        for (auto const& rhs : rhsList) {
+            (withinEditDistance(challenge, rhs, k));
+        }
+    }
+
+    int64_t bytes = 0;
+    for (auto const& rhs : rhsList) {
+        bytes += rhs.size() + challenge.size();
+    }
+    state.SetBytesProcessed(bytes * state.iterations());
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+
+    for (auto const& rhs : rhsList) {
+        if (withinEditDistance(challenge, rhs, k) != (editDistanceSlow(challenge, rhs) <= k)) {
+            state.SkipWithError("Check failed (DISTANCE)");
+        }
+    }
+}
+
+static void BM_levenshtein(benchmark::State& state, std::string const& challenge) {
+    std::array<std::string, MAX_EDITS + 1> rhsList;
+    for (unsigned i = 0; i != rhsList.size(); ++i) {
+        rhsList[i] = withEdits(challenge, i);
+    }
+
+    for (auto _ : state) {
+        for (auto const& rhs : rhsList) {
+            (editDistanceSlow(challenge, rhs));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+}
+
+static std::string encodeUtf8(char32_t cp) {
+    std::string result;
+    if (cp < 0x80) {
+        result.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        result.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+        result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+        result.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+        result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else {
+        result.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+        result.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+        result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+        result.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+    return result;
+}
+
+using Alphabet = std::vector<std::string>;
+
+static Alphabet script(std::initializer_list<std::pair<char32_t, char32_t>> ranges) {
+    Alphabet alphabet;
+    for (auto [first, last] : ranges) {
+        for (auto cp = first; cp <= last; ++cp) {
+            alphabet.push_back(encodeUtf8(cp));
+        }
+    }
+    return alphabet;
+}
+
+static inline Alphabet ASCII_NAMES = script({{'a', 'z'}, {'A', 'Z'}});
+static inline Alphabet LATIN_NAMES = script({{'a', 'z'}, {0xe0, 0xff}}); // accented Latin-1
+static inline Alphabet CYRILLIC_NAMES = script({{0x410, 0x44f}});
+static inline Alphabet CJK_NAMES = script({{0x4e00, 0x4fff}});
+static inline Alphabet MIXED_NAMES = script({{'a', 'z'}, {0xe0, 0xff}, {0x410, 0x44f}, {0x4e00, 0x4fff},
+                                             {0x1f600, 0x1f64f}});
+
+static std::vector<std::string> genUtf8(Alphabet const& alphabet, size_t codePoints) {
+    std::mt19937 engine(codePoints);
+    std::uniform_int_distribution<size_t> symbol(0, alphabet.size() - 1);
+    std::vector<std::string> result(codePoints);
+    for (auto& cp : result) {
+        cp = alphabet[symbol(engine)];
+    }
+    return result;
+}
+
+// Names of state.range(0) code points: equal, one code point replaced by one of another script,
+// deleted, inserted, and two replaced
+static void BM_utf8(benchmark::State& state, fn fn, Alphabet const& alphabet) {
+    const auto codePoints = genUtf8(alphabet, state.range(0));
+    const auto join = [](std::vector<std::string> const& cps) {
+        std::string result;
+        for (auto const& cp : cps) {
+            result += cp;
+        }
+        return result;
+    };
+    const auto mid = codePoints.size() / 2;
+    const std::string lhs = join(codePoints);
+    std::array<std::vector<std::string>, 5> variants;
+    variants.fill(codePoints);
+    variants[1][mid] = encodeUtf8(codePoints[mid] == "\u00e9" ? 0x6771 : 0xe9);
+    variants[2].erase(variants[2].begin() + mid);
+    variants[3].insert(variants[3].begin() + mid, encodeUtf8(0x1f600));
+    variants[4][mid] = variants[1][mid];
+    variants[4].back() = encodeUtf8(codePoints.back() == "x" ? 'y' : 'x');
+
+    std::array<std::string, variants.size()> rhsList;
+    int64_t bytes = 0;
+    for (size_t i = 0; i != variants.size(); ++i) {
+        rhsList[i] = join(variants[i]);
+        bytes += lhs.size() + rhsList[i].size();
+    }
+
+    for (auto _ : state) {
+        for (auto const& rhs : rhsList) {
+            (fn(lhs, rhs));
+        }
+    }
+    state.SetBytesProcessed(bytes * state.iterations());
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+
+    if (fn == oneChangeUtf8) {
+        for (size_t i = 0; i != rhsList.size(); ++i) {
+            if (fn(lhs, rhsList[i]) != (i != 4)) {
+                state.SkipWithError("Check failed (UTF8)");
+            }
+        }
+    }
+}
+
+// Candidates around the query size: 1/4 of them are one edit away, the rest are random
+static std::vector<std::string> genCandidates(std::string const& query, size_t count) {
+    std::vector<std::string> candidates;
+    candidates.reserve(count);
+    for (size_t i = 0; i != count; ++i) {
+        if (i % 4 == 0) {
+            auto diffList = std::array<DiffFn, DIFF_COUNT>{diff1, diff2, diff3, diff4, diff5, diff6};
+            candidates.push_back(diffList[i / 4 % DIFF_COUNT](query));
+        } else {
+            candidates.push_back(gen(query.size() + i % 3 - 1));
+        }
+    }
+    return candidates;
+}
+
+static void BM_batch(benchmark::State& state, std::string const& query) {
+    const auto storage = genCandidates(query, state.range(0));
+    std::vector<sv> candidates(storage.begin(), storage.end());
+    std::vector<uint64_t> out((candidates.size() + 63) / 64);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(oneChangeBatch(query, candidates, out));
+    }
+
+    state.SetItemsProcessed(state.iterations() * candidates.size());
+    for (size_t i = 0; i != candidates.size(); ++i) {
+        if (((out[i / 64] >> (i % 64)) & 1) != oneChangeSlow(query, candidates[i])) {
+            state.SkipWithError("Check failed (BATCH)");
+            break;
+        }
+    }
+}
+
+static void BM_batchLoop(benchmark::State& state, std::string const& query) {
+    const auto storage = genCandidates(query, state.range(0));
+    std::vector<sv> candidates(storage.begin(), storage.end());
+    std::vector<uint64_t> out((candidates.size() + 63) / 64);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i != candidates.size(); ++i) {
+            out[i / 64] |= uint64_t{oneChangeFastAVX(query, candidates[i])} << (i % 64);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * candidates.size());
+}
+
+// Pairs of `size` bytes: equal, one and two edits apart. Arg 1: 0 is oneChangeShortBatch(), 1 is oneChangeFast() and
+// 2 is oneChangeAuto() per pair
+static void BM_shortBatch(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const auto kernel = state.range(1);
+    constexpr size_t PAIRS = 4096;
+    std::vector<std::string> storage;
+    for (size_t i = 0; i != PAIRS; ++i) {
+        storage.push_back(gen(size));
+        storage.push_back(withEdits(storage.back(), i % 3));
+    }
+    std::vector<sv> lhs;
+    std::vector<sv> rhs;
+    for (size_t i = 0; i != storage.size(); i += 2) {
+        lhs.emplace_back(storage[i]);
+        rhs.emplace_back(storage[i + 1]);
+    }
+    std::vector<uint32_t> out(PAIRS / 32);
+
+    const auto perPair = [&](fn fn) {
+        for (size_t i = 0; i != PAIRS; ++i) {
+            out[i / 32] |= uint32_t{fn(lhs[i], rhs[i])} << (i % 32);
+        }
+    };
+    for (auto _ : state) {
+        switch (kernel) {
+            case 0: benchmark::DoNotOptimize(oneChangeShortBatch(lhs, rhs, out)); break;
+            case 1: perPair(oneChangeFast); break;
+            default: perPair(oneChangeAuto);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * PAIRS));
+    state.SetLabel(kernel == 0 ? "shortBatch" : kernel == 1 ? "sseFast" : "auto");
+
+    std::fill(out.begin(), out.end(), 0);
+    oneChangeShortBatch(lhs, rhs, out);
+    for (size_t i = 0; i != PAIRS; ++i) {
+        if (((out[i / 32] >> (i % 32)) & 1) != oneChangeSlow(lhs[i], rhs[i])) {
+            state.SkipWithError("Check failed (SHORT_BATCH)");
+            break;
+        }
+    }
+}
+
+// Column-vs-column over Arrow-style buffers: oneChangeColumn() on padded (arg 0) and unpadded (1) columns,
+// against materializing a view per row and calling oneChangeAuto() (2)
+static void BM_column(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const auto kernel = state.range(1);
+    constexpr size_t ROWS = 1 << 16;
+    StringColumnBuilder lhsBuilder;
+    StringColumnBuilder rhsBuilder;
+    for (size_t i = 0; i != ROWS; ++i) {
+        const auto lhs = gen(size);
+        lhsBuilder.append(lhs);
+        rhsBuilder.append(withEdits(lhs, i % 3));
+    }
+    auto lhs = lhsBuilder.column();
+    auto rhs = rhsBuilder.column();
+    std::vector<StringColumn::offset_t> lhsOffsets;
+    std::vector<StringColumn::offset_t> rhsOffsets;
+    for (size_t i = 0; i <= ROWS; ++i) {
+        lhsOffsets.push_back(static_cast<StringColumn::offset_t>(lhs.row(i) - lhs.row(0)));
+        rhsOffsets.push_back(static_cast<StringColumn::offset_t>(rhs.row(i) - rhs.row(0)));
+    }
+    if (kernel != 0) {
+        lhs = StringColumn(lhsOffsets, {lhs.row(0), static_cast<size_t>(lhsOffsets.back())});
+        rhs = StringColumn(rhsOffsets, {rhs.row(0), static_cast<size_t>(rhsOffsets.back())});
+    }
+    std::vector<uint64_t> out(ROWS / 64);
+    std::vector<sv> lhsViews;
+    std::vector<sv> rhsViews;
+
+    for (auto _ : state) {
+        if (kernel == 2) {
+            lhsViews.clear();
+            rhsViews.clear();
+            for (size_t i = 0; i != ROWS; ++i) {
+                lhsViews.push_back(lhs[i]);
+                rhsViews.push_back(rhs[i]);
+            }
+            for (size_t i = 0; i != ROWS; ++i) {
+                out[i / 64] |= uint64_t{oneChangeAuto(lhsViews[i], rhsViews[i])} << (i % 64);
+            }
+        } else {
+            benchmark::DoNotOptimize(oneChangeColumn(lhs, rhs, out));
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ROWS));
+    state.SetLabel(kernel == 0 ? "padded" : kernel == 1 ? "unpadded" : "views+auto");
+
+    std::fill(out.begin(), out.end(), 0);
+    oneChangeColumn(lhs, rhs, out);
+    for (size_t i = 0; i != ROWS; ++i) {
+        if (((out[i / 64] >> (i % 64)) & 1) != oneChangeSlow(lhs[i], rhs[i])) {
+            state.SkipWithError("Check failed (COLUMN)");
+            break;
+        }
+    }
+}
+
+// 1 MB streams with an insert in the middle fed in chunks of range(0) bytes, lhs one chunk ahead of rhs,
+// against oneChangeAuto() on the whole buffers (range(0) == 0)
+static void BM_matcher(benchmark::State& state) {
+    const auto chunk = static_cast<size_t>(state.range(0));
+    static const std::string lhs = gen(1 << 20);
+    static const std::string rhs = [] {
+        auto str = lhs;
+        str.insert(str.size() / 2, 1, '#');
+        return str;
+    }();
+    size_t buffered = 0;
+    for (auto _ : state) {
+        if (chunk == 0) {
+            benchmark::DoNotOptimize(oneChangeAuto(lhs, rhs));
+            continue;
+        }
+        OneChangeMatcher matcher;
+        matcher.feedLhs(sv(lhs).substr(0, chunk));
+        for (size_t i = 0; i < rhs.size(); i += chunk) {
+            matcher.feedLhs(sv(lhs).substr(std::min(i + chunk, lhs.size()), chunk));
+            matcher.feedRhs(sv(rhs).substr(i, chunk));
+            buffered = std::max(buffered, matcher.buffered());
+        }
+        if (!matcher.finish()) {
+            state.SkipWithError("Check failed (MATCHER)");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>((lhs.size() + rhs.size()) * state.iterations()));
+    state.counters["maxBuffered"] = static_cast<double>(buffered);
+}
+
+// 1 MB text with one-edit copies of the pattern planted every range(1) bytes (0: none), pattern of range(0)
+// bytes; range(2) == 1 is the naive scan: oneChangeAuto() on the three windows at every offset
+static void BM_findOneEdit(benchmark::State& state) {
+    const auto patternSize = static_cast<size_t>(state.range(0));
+    const auto every = static_cast<size_t>(state.range(1));
+    const bool naive = state.range(2) == 1;
+    const auto pattern = gen(patternSize);
+    auto text = gen(1 << 20);
+    for (size_t pos = every; every != 0 && pos + patternSize < text.size(); pos += every) {
+        text.replace(pos, patternSize, withEdits(pattern, 1));
+    }
+
+    size_t found = 0;
+    for (auto _ : state) {
+        found = 0;
+        if (naive) {
+            for (size_t pos = 0; pos + patternSize - 1 <= text.size(); ++pos) {
+                for (size_t size = patternSize - 1; size <= patternSize + 1; ++size) {
+                    found += pos + size <= text.size() && oneChangeAuto(sv(text).substr(pos, size), pattern);
+                }
+            }
+        } else {
+            findOneEdit(text, pattern, [&found](size_t, size_t) { ++found; });
+        }
+        benchmark::DoNotOptimize(found);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(text.size() * state.iterations()));
+    state.counters["found"] = static_cast<double>(found);
+}
+
+// Dictionary of short words and queries for it: every second query is a dictionary word with one edit
+struct Dictionary {
+    std::vector<std::string> words;
+    std::vector<sv> entries;
+    std::vector<std::string> queries;
+
+    explicit Dictionary(size_t count) {
+        std::mt19937 engine(count);
+        std::uniform_int_distribution<size_t> size(4, 12);
+        words.reserve(count);
+        for (size_t i = 0; i != count; ++i) {
+            words.push_back(gen(size(engine)));
+        }
+        entries.assign(words.begin(), words.end());
+        for (size_t i = 0; i != 256; ++i) {
+            queries.push_back(i % 2 == 0 ? diff1(words[engine() % count]) : gen(size(engine)));
+        }
+    }
+
+    static Dictionary const& get(size_t count) {
+        static std::map<size_t, Dictionary> cache;
+        return cache.try_emplace(count, count).first->second;
+    }
+};
+
+static void BM_indexBuild(benchmark::State& state) {
+    auto const& dictionary = Dictionary::get(state.range(0));
+    size_t memory = 0;
+    for (auto _ : state) {
+        OneEditIndex index(dictionary.entries);
+        memory = index.memoryUsage();
+        benchmark::DoNotOptimize(memory);
+    }
+
+    state.SetItemsProcessed(state.iterations() * dictionary.entries.size());
+    state.counters["bytes_per_entry"] = static_cast<double>(memory) / dictionary.entries.size();
+}
+
+static void BM_indexQuery(benchmark::State& state) {
+    auto const& dictionary = Dictionary::get(state.range(0));
+    const OneEditIndex index(dictionary.entries);
+    std::vector<OneEditIndex::id_t> result;
+    for (auto _ : state) {
+        for (auto const& query : dictionary.queries) {
+            index.query(query, result);
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * dictionary.queries.size());
+}
+
+static void BM_scanQuery(benchmark::State& state) {
+    auto const& dictionary = Dictionary::get(state.range(0));
+    std::vector<OneEditIndex::id_t> result;
+    for (auto _ : state) {
+        for (auto const& query : dictionary.queries) {
+            result.clear();
+            for (OneEditIndex::id_t id = 0; id != dictionary.entries.size(); ++id) {
+                if (oneChangeFastAVX(query, dictionary.entries[id])) {
+                    result.push_back(id);
+                }
+            }
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * dictionary.queries.size());
+}
+
+// Titles of 8..24 symbols, every fifth one is a one-edit copy of an earlier title
+static std::vector<std::string> const& genTitles(size_t count) {
+    static std::map<size_t, std::vector<std::string>> cache;
+    auto [it, inserted] = cache.try_emplace(count);
+    if (inserted) {
+        std::mt19937 engine(count);
+        std::uniform_int_distribution<size_t> size(8, 24);
+        auto diffList = std::array<DiffFn, DIFF_COUNT>{diff1, diff2, diff3, diff4, diff5, diff6};
+        for (size_t i = 0; i != count; ++i) {
+            it->second.push_back(i % 5 == 4 ? diffList[i % DIFF_COUNT](it->second[engine() % i]) : gen(size(engine)));
+        }
+    }
+    return it->second;
+}
+
+static void BM_selfJoin(benchmark::State& state) {
+    auto const& titles = genTitles(state.range(0));
+    const std::vector<sv> strings(titles.begin(), titles.end());
+    WorkStealingPool pool(state.range(1));
+    std::atomic<size_t> pairs = 0;
+    for (auto _ : state) {
+        pairs = 0;
+        oneEditSelfJoin(strings, [&](size_t, size_t) {
+            pairs.fetch_add(1, std::memory_order_relaxed);
+        }, pool);
+    }
+
+    state.SetItemsProcessed(state.iterations() * strings.size());
+    state.counters["pairs"] = pairs.load();
+}
+
+static void BM_selfJoinBruteForce(benchmark::State& state) {
+    auto const& titles = genTitles(state.range(0));
+    const std::vector<sv> strings(titles.begin(), titles.end());
+    size_t pairs = 0;
+    for (auto _ : state) {
+        pairs = 0;
+        for (size_t i = 0; i != strings.size(); ++i) {
+            for (size_t j = i + 1; j != strings.size(); ++j) {
+                pairs += oneChangeFastAVX(strings[i], strings[j]);
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * strings.size());
+    state.counters["pairs"] = pairs;
+}
+
 static void BM_memcmp(benchmark::State& state, std::string const& challenge) {
     void *buffer = malloc(challenge.size());
     for (auto _ : state) {
@@ -123,12 +702,23 @@ static void BM_memcmp(benchmark::State& state, std::string const& challenge) {
     free(buffer);
 }
 
+// memcmp() of two equal copies: the load bandwidth bound of the long BM_eq runs
+static void BM_memcmpEq(benchmark::State& state, std::string const& challenge) {
+    const std::string copy = challenge;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(memcmp(challenge.data(), copy.data(), challenge.size()));
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(2 * challenge.size() * state.iterations()));
+}
+
 static constexpr auto L1_CACHE_SIZE = 32 * 1024;
 static constexpr auto LOAD_TEST_SIZE = L1_CACHE_SIZE * 8;
 
 static void BM_SIMDLoadAlign(benchmark::State& state) {
     alignas(64) char str[LOAD_TEST_SIZE];
     alignas(64) char str2[LOAD_TEST_SIZE];
+    PerfScope perf(state);
     for (auto _ : state) {
         for (auto i = 0; i < LOAD_TEST_SIZE; i += 64) { // we read only 32 bites, but I want to skip cache line
             auto lhs = _mm256_load_si256(reinterpret_cast<const __m256i*>(str + i));
@@ -139,11 +729,13 @@ static void BM_SIMDLoadAlign(benchmark::State& state) {
     }
 
     state.SetBytesProcessed(LOAD_TEST_SIZE * state.iterations());
+    perf.report();
 }
 
 static void BM_SIMDULoadAlign(benchmark::State& state) {
     alignas(64) char str[LOAD_TEST_SIZE];
     alignas(64) char str2[LOAD_TEST_SIZE];
+    PerfScope perf(state);
     for (auto _ : state) {
         for (auto i = 0; i < LOAD_TEST_SIZE; i += 64) { // we read only 32 bites, but I want to skip cache line
             auto lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
@@ -154,11 +746,13 @@ static void BM_SIMDULoadAlign(benchmark::State& state) {
     }
 
     state.SetBytesProcessed(LOAD_TEST_SIZE * state.iterations());
+    perf.report();
 }
 
 static void BM_SIMDULoadUnAlign(benchmark::State& state) {
     alignas(64) char str[LOAD_TEST_SIZE + 1];
     alignas(64) char str2[LOAD_TEST_SIZE + 1];
+    PerfScope perf(state);
     for (auto _ : state) {
         for (auto i = 1; i < LOAD_TEST_SIZE + 1; i += 64) { // we read only 32 bites, but I want to skip cache line
             auto lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
@@ -169,12 +763,14 @@ static void BM_SIMDULoadUnAlign(benchmark::State& state) {
     }
 
     state.SetBytesProcessed(LOAD_TEST_SIZE * state.iterations());
+    perf.report();
 }
 
 static void BM_SIMDULoadUnAlignCacheLines(benchmark::State& state) {
     constexpr auto shift = 60;
     alignas(64) char str[LOAD_TEST_SIZE + shift];
     alignas(64) char str2[LOAD_TEST_SIZE + shift];
+    PerfScope perf(state);
     for (auto _ : state) {
         for (auto i = shift; i < LOAD_TEST_SIZE + shift; i += 64) { // we read only 32 bites, but I want to skip whole cache line
             auto lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
@@ -185,10 +781,12 @@ static void BM_SIMDULoadUnAlignCacheLines(benchmark::State& state) {
     }
 
     state.SetBytesProcessed(LOAD_TEST_SIZE * state.iterations());
+    perf.report();
 }
 
 static inline std::string SHORT_CHALLENGE = gen(15);
 static inline std::string MID_CHALLENGE = gen(45);
+static inline std::string MID300_CHALLENGE = gen(300);
 static inline std::string LONG_CHALLENGE = gen(16 * 80 + 5); // 1285 = 1 Kb
 static inline std::string LONG10_CHALLENGE = gen(1024 * 10 + 13); // 10 Kb
 static inline std::string LONG30_CHALLENGE = gen(1024 * 30 + 11); // 30 Kb
@@ -200,6 +798,8 @@ BENCHMARK_CAPTURE(BM_eq, EQ_15_ ## name, fn, SHORT_CHALLENGE); \
 BENCHMARK_CAPTURE(BM_diff, DIFF_15_ ## name, fn, SHORT_CHALLENGE);\
 BENCHMARK_CAPTURE(BM_eq, EQ_45_ ## name, fn, MID_CHALLENGE);\
 BENCHMARK_CAPTURE(BM_diff, DIFF_45_ ## name, fn, MID_CHALLENGE);\
+BENCHMARK_CAPTURE(BM_eq, EQ_300_ ## name, fn, MID300_CHALLENGE);\
+BENCHMARK_CAPTURE(BM_diff, DIFF_300_ ## name, fn, MID300_CHALLENGE);\
 BENCHMARK_CAPTURE(BM_eq, EQ_1285_ ## name, fn, LONG_CHALLENGE);\
 BENCHMARK_CAPTURE(BM_diff, DIFF_1285_ ## name, fn, LONG_CHALLENGE);\
 BENCHMARK_CAPTURE(BM_eq, EQ_10Kb_ ## name, fn, LONG10_CHALLENGE);\
@@ -213,11 +813,398 @@ DEF_BENCH(slow, oneChangeSlow);
 DEF_BENCH(fast, oneChangeNoSIMDFast);
 DEF_BENCH(sse, oneChange);
 DEF_BENCH(avx, oneChangeAVX);
-DEF_BENCH(sseFast, oneChangeFast);
-DEF_BENCH(avxFast, oneChangeFastAVX);
+DEF_BENCH(auto, oneChangeAuto); // ONECHANGE_SIMD=... to bench a lower tier
+DEF_BENCH(detail, oneChangeDetailBool);
+DEF_BENCH(transpose, oneChangeOrTranspose);
+DEF_BENCH(twoEnded, oneChangeTwoEnded);
+DEF_BENCH(twoEndedParallel, oneChangeTwoEndedParallel);
+
+// Short strings are all tail: equal, last symbol replaced and last symbol deleted at every size 0..64.
+// The strings sit in one buffer with 64 bytes of slack after each of them.
+static void BM_tail(benchmark::State& state, fn fn) {
+    if (skipUnsupported(state, fn)) {
+        return;
+    }
+
+    constexpr size_t SLACK = 64; // >= ONECHANGE_PADDING
+    const auto size = static_cast<size_t>(state.range(0));
+    std::string buffer = gen(3 * (size + SLACK));
+    char* const equal = buffer.data() + size + SLACK;
+    char* const replaced = equal + size + SLACK;
+    std::memcpy(equal, buffer.data(), size);
+    std::memcpy(replaced, buffer.data(), size);
+    if (size != 0) {
+        changeSymbol(replaced[size - 1]);
+    }
+    const sv lhs(buffer.data(), size);
+    const std::array<sv, 3> rhsList{sv(equal, size), sv(replaced, size), sv(equal, size - (size != 0))};
+
+    for (auto _ : state) {
+        for (size_t i = 0; i != rhsList.size(); ++i) {
+            (fn(lhs, rhsList[i]));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+
+    for (size_t i = 0; i != rhsList.size(); ++i) {
+        if (fn(lhs, rhsList[i]) != oneChangeSlow(lhs, rhsList[i])) {
+            state.SkipWithError("Check failed (TAIL)");
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(BM_tail, fast, oneChangeNoSIMDFast)->DenseRange(0, 64);
+BENCHMARK_CAPTURE(BM_tail, padded, oneChangePadded)->DenseRange(0, 64);
+
+// The Fast kernel matrix is generated from FAST_KERNELS: a new vector width shows up in every table above
+[[maybe_unused]] static const bool FAST_KERNELS_REGISTERED = [] {
+    const std::pair<sv, std::string const*> challenges[] = {
+            {"15", &SHORT_CHALLENGE}, {"45", &MID_CHALLENGE}, {"300", &MID300_CHALLENGE}, {"1285", &LONG_CHALLENGE},
+            {"10Kb", &LONG10_CHALLENGE}, {"30Kb", &LONG30_CHALLENGE}, {"120Kb", &INF_CHALLENGE}};
+    for (auto const& kernel : FAST_KERNELS) {
+        const std::string name(kernel.name);
+        for (auto const& [size, challenge] : challenges) {
+            const std::string suffix = std::string(size) + "_" + name;
+            benchmark::RegisterBenchmark(("BM_eq/EQ_" + suffix).c_str(), BM_eq, kernel.fn, *challenge);
+            benchmark::RegisterBenchmark(("BM_diff/DIFF_" + suffix).c_str(), BM_diff, kernel.fn, *challenge);
+        }
+        benchmark::RegisterBenchmark(("BM_tail/" + name).c_str(), BM_tail, kernel.fn)->DenseRange(0, 64);
+    }
+    return true;
+}();
+
+// Case-insensitive: folding in the kernel registers vs lowercased copies passed to the byte kernel
+static std::string asciiLower(sv str) {
+    std::string result(str);
+    for (auto& c : result) {
+        c = c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+    }
+    return result;
+}
+
+static bool oneChangeLowerCopies(sv lhs, sv rhs) {
+    return oneChangeAuto(asciiLower(lhs), asciiLower(rhs));
+}
+
+static void BM_folded(benchmark::State& state, fn fn, std::string const& challenge) {
+    auto diffList = std::array<DiffFn, DIFF_COUNT>{diff1, diff2, diff3, diff4, diff5, diff6};
+    std::array<std::string, DIFF_COUNT> rhsList;
+    for (auto i = 0; i != DIFF_COUNT; ++i) {
+        rhsList[i] = diffList[i](challenge);
+        for (auto& c : rhsList[i]) {
+            c = std::isalpha(static_cast<unsigned char>(c)) ? static_cast<char>(c ^ 0x20) : c;
+        }
+    }
+
+    for (auto _ : state) {
+        for (auto const& rhs : rhsList) {
+            (fn(challenge, rhs));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+
+    for (auto const& rhs : rhsList) {
+        if (fn(challenge, rhs) != oneChangeSlow(asciiLower(challenge), asciiLower(rhs))) {
+            state.SkipWithError("Check failed (FOLDED)");
+        }
+    }
+}
+
+#define DEF_FOLDED_BENCH(name, challenge) \
+BENCHMARK_CAPTURE(BM_folded, FOLDED_ ## name ## _caseFold, oneChangeFolded<AsciiCaseFold>, challenge); \
+BENCHMARK_CAPTURE(BM_folded, FOLDED_ ## name ## _lowerCopies, oneChangeLowerCopies, challenge);
+
+DEF_FOLDED_BENCH(15, SHORT_CHALLENGE);
+DEF_FOLDED_BENCH(45, MID_CHALLENGE);
+DEF_FOLDED_BENCH(300, MID300_CHALLENGE);
+DEF_FOLDED_BENCH(1285, LONG_CHALLENGE);
+
+// 16/32-bit elements: equal, middle element replaced, element inserted in the middle, last element appended
+template <typename T>
+static void BM_wide(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    std::mt19937 engine(size);
+    std::vector<T> lhs(size);
+    for (auto& c : lhs) {
+        c = static_cast<T>(engine());
+    }
+    std::array<std::vector<T>, 4> rhsList{lhs, lhs, lhs, lhs};
+    rhsList[1][size / 2] ^= 1;
+    rhsList[2].insert(rhsList[2].begin() + size / 2, T{1});
+    rhsList[3].push_back(T{1});
+
+    for (auto _ : state) {
+        for (auto const& rhs : rhsList) {
+            (oneChangeWide(std::span<const T>(lhs), std::span<const T>(rhs)));
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(8 * size * sizeof(T) * state.iterations()));
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+
+    for (auto const& rhs : rhsList) {
+        if (!oneChangeWide(std::span<const T>(lhs), std::span<const T>(rhs))) {
+            state.SkipWithError("Check failed (WIDE)");
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_wide, uint16_t)->Arg(15)->Arg(45)->Arg(300)->Arg(1285)->Arg(10 * 1024 + 13);
+BENCHMARK_TEMPLATE(BM_wide, uint32_t)->Arg(15)->Arg(45)->Arg(300)->Arg(1285)->Arg(10 * 1024 + 13);
+
+// Keys of N bytes: equal, middle byte replaced, deleted, inserted, two bytes replaced.
+// Arg 0 is oneChangeFixed<N>, 1 is oneChangeFastAVX on the same keys, 2 is oneChangeAuto (takes the fixed kernel)
+template <size_t N>
+static void BM_fixed(benchmark::State& state) {
+    const auto kernel = state.range(0);
+    if (kernel == 1 && detectSimdLevel() < SimdLevel::AVX2) {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+
+    const std::string lhs = gen(N);
+    std::array<std::string, 5> rhsList{lhs, lhs, lhs, lhs, lhs};
+    changeSymbol(rhsList[1][N / 2]);
+    rhsList[2].erase(N / 2, 1);
+    rhsList[3].insert(N / 2, 1, '#');
+    changeSymbol(rhsList[4][N / 3]);
+    changeSymbol(rhsList[4][2 * N / 3]);
+
+    const auto run = [&]() {
+        unsigned found = 0;
+        if (kernel == 0) {
+            found += oneChangeFixed<N>(lhs.data(), rhsList[0].data());
+            found += oneChangeFixed<N>(lhs.data(), rhsList[1].data());
+            found += oneChangeFixed<N, N - 1>(lhs.data(), rhsList[2].data());
+            found += oneChangeFixed<N, N + 1>(lhs.data(), rhsList[3].data());
+            found += oneChangeFixed<N>(lhs.data(), rhsList[4].data());
+        } else {
+            const auto fn = kernel == 1 ? oneChangeFastAVX : oneChangeAuto;
+            for (auto const& rhs : rhsList) {
+                found += fn(lhs, rhs);
+            }
+        }
+        return found;
+    };
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(run());
+    }
+    state.SetItemsProcessed(state.iterations() * rhsList.size());
+    state.SetLabel(kernel == 0 ? "fixed" : kernel == 1 ? "avxFast" : "auto");
+
+    if (run() != 4) {
+        state.SkipWithError("Check failed (FIXED)");
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_fixed, 16)->DenseRange(0, 2);
+BENCHMARK_TEMPLATE(BM_fixed, 32)->DenseRange(0, 2);
+BENCHMARK_TEMPLATE(BM_fixed, 64)->DenseRange(0, 2);
+
+// Workloads: pools of distinct pairs with lengths, edit positions and the verdict mix drawn from distributions,
+// instead of one hot pair. Each runs warm (the pool fits in L2) and cold (4x the last level cache, so every pair
+// misses the caches and the branch history). ONECHANGE_WORKLOAD_LENGTHS=file adds the "empirical" workload with
+// the lengths of a histogram file ("length weight" lines). The JSON report (--benchmark_out=run.json
+// --benchmark_out_format=json) has the configs in its context, runs are compared with benchmark's compare.py.
+static std::vector<WorkloadConfig> workloadConfigs() {
+    const auto anywhere = IntDistribution::uniform(0, 100);
+    std::vector<WorkloadConfig> configs{
+            {"names", IntDistribution::uniform(4, 24), anywhere, 0.1, 0.3, 0.6},
+            {"keys32", IntDistribution::fixed(32), anywhere, 0.5, 0.1, 0.4},
+            {"mixed", IntDistribution::histogram({{8, 4}, {15, 8}, {32, 6}, {45, 4}, {300, 1}, {1285, 0.5}}), anywhere,
+             0.2, 0.4, 0.4},
+            {"docsTailEdits", IntDistribution::uniform(1000, 12000), IntDistribution::uniform(90, 100), 0.3, 0.4, 0.3},
+    };
+    if (const char* path = std::getenv("ONECHANGE_WORKLOAD_LENGTHS")) {
+        configs.push_back({"empirical", IntDistribution::histogramFile(path), anywhere, 0.2, 0.4, 0.4});
+    }
+    return configs;
+}
+
+static inline const std::vector<WorkloadConfig> WORKLOADS = workloadConfigs();
+
+// The benchmarks of a workload run one after another: only the current pool is kept
+static Workload const& workloadPool(WorkloadConfig const& config, bool cold) {
+    constexpr size_t WARM_BYTES = 256 << 10;
+    constexpr size_t MAX_COLD_BYTES = size_t{1} << 30;
+    static std::string current;
+    static std::unique_ptr<Workload> pool;
+
+    const auto key = config.name + (cold ? "_cold" : "_warm");
+    if (key != current) {
+        pool.reset();
+        pool = std::make_unique<Workload>(config, cold ? std::min(4 * lastLevelCacheSize(), MAX_COLD_BYTES) : WARM_BYTES);
+        current = key;
+    }
+    return *pool;
+}
+
+static void BM_workload(benchmark::State& state, fn fn, WorkloadConfig const* config, bool cold) {
+    if (skipUnsupported(state, fn)) {
+        return;
+    }
+
+    auto const& pool = workloadPool(*config, cold);
+    const auto pairs = pool.pairs();
+    size_t i = 0;
+    size_t bytes = 0;
+    PerfScope perf(state);
+    for (auto _ : state) {
+        auto const& pair = pairs[i];
+        benchmark::DoNotOptimize(fn(pair.lhs, pair.rhs));
+        bytes += pair.lhs.size() + pair.rhs.size();
+        i = i + 1 == pairs.size() ? 0 : i + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    perf.report();
+    state.counters["pairs"] = static_cast<double>(pairs.size());
+    state.counters["poolMiB"] = static_cast<double>(pool.bytes()) / (1 << 20);
+
+    for (auto const& pair : pairs) {
+        if (fn(pair.lhs, pair.rhs) != pair.oneChange) {
+            state.SkipWithError("Check failed (WORKLOAD)");
+            break;
+        }
+    }
+}
+
+[[maybe_unused]] static const bool WORKLOADS_REGISTERED = [] {
+    std::vector<std::pair<std::string, fn>> kernels{{"auto", oneChangeAuto}, {"twoEnded", oneChangeTwoEnded}};
+    for (auto const& kernel : FAST_KERNELS) {
+        kernels.emplace_back(kernel.name, kernel.fn);
+    }
+    for (auto const& config : WORKLOADS) {
+        benchmark::AddCustomContext("workload." + config.name, toJson(config));
+        for (bool cold : {false, true}) {
+            for (auto const& [name, kernel] : kernels) {
+                const auto benchName = "BM_workload/" + config.name + (cold ? "_cold_" : "_warm_") + name;
+                benchmark::RegisterBenchmark(benchName.c_str(), BM_workload, kernel, &config, cold);
+            }
+        }
+    }
+    return true;
+}();
+
+// Latency distribution: each sample times `batch` calls with serialized rdtsc/rdtscp, less the timer overhead,
+// over the EQ pair and the six DIFF pairs in turn. Percentiles are in ns per call: the mean of BM_eq/BM_diff
+// hides the rare paths (a diff-size pair with several mismatches in a vector goes to the scalar fallback).
+static void BM_latency(benchmark::State& state, fn fn, std::string const& challenge) {
+    if (skipUnsupported(state, fn)) {
+        return;
+    }
+
+    auto diffList = std::array<DiffFn, DIFF_COUNT>{diff1, diff2, diff3, diff4, diff5, diff6};
+    std::array<std::string, DIFF_COUNT + 1> rhsList;
+    rhsList[0] = challenge;
+    for (size_t i = 0; i != DIFF_COUNT; ++i) {
+        rhsList[i + 1] = diffList[i](challenge);
+    }
+
+    const auto batch = static_cast<size_t>(state.range(0));
+    const auto overhead = tscOverhead();
+    LatencyHistogram histogram;
+    size_t next = 0;
+    for (auto _ : state) {
+        auto const& rhs = rhsList[next];
+        const auto begin = tscBegin();
+        for (size_t i = 0; i != batch; ++i) {
+            benchmark::DoNotOptimize(fn(challenge, rhs));
+        }
+        const auto ticks = tscEnd() - begin;
+        histogram.record((ticks > overhead ? ticks - overhead : 0) / batch);
+        next = next + 1 == rhsList.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch));
+
+    const auto ns = [&](uint64_t ticks) {
+        return static_cast<double>(ticks) / tscTicksPerNs();
+    };
+    state.counters["p50"] = ns(histogram.percentile(0.5));
+    state.counters["p90"] = ns(histogram.percentile(0.9));
+    state.counters["p99"] = ns(histogram.percentile(0.99));
+    state.counters["p99.9"] = ns(histogram.percentile(0.999));
+    state.counters["max"] = ns(histogram.max());
+    state.counters["timerOverhead"] = ns(overhead);
+
+    for (auto const& rhs : rhsList) {
+        if (fn(challenge, rhs) != oneChangeSlow(challenge, rhs)) {
+            state.SkipWithError("Check failed (LATENCY)");
+        }
+    }
+}
+
+[[maybe_unused]] static const bool LATENCY_REGISTERED = [] {
+    const std::pair<sv, std::string const*> challenges[] = {
+            {"15", &SHORT_CHALLENGE}, {"45", &MID_CHALLENGE}, {"300", &MID300_CHALLENGE}, {"1285", &LONG_CHALLENGE},
+            {"10Kb", &LONG10_CHALLENGE}};
+    std::vector<std::pair<std::string, fn>> kernels{
+            {"sse", oneChange}, {"avx", oneChangeAVX}, {"auto", oneChangeAuto}, {"twoEnded", oneChangeTwoEnded}};
+    for (auto const& kernel : FAST_KERNELS) {
+        kernels.emplace_back(kernel.name, kernel.fn);
+    }
+    for (auto const& [name, kernel] : kernels) {
+        for (auto const& [size, challenge] : challenges) {
+            const auto benchName = "BM_latency/" + std::string(size) + "_" + name;
+            benchmark::RegisterBenchmark(benchName.c_str(), BM_latency, kernel, *challenge)->Arg(1)->Arg(16);
+        }
+    }
+    return true;
+}();
+
+#define DEF_DISTANCE_BENCH(k) \
+BENCHMARK_CAPTURE(BM_distance, DIST_15_k ## k, k, SHORT_CHALLENGE); \
+BENCHMARK_CAPTURE(BM_distance, DIST_45_k ## k, k, MID_CHALLENGE); \
+BENCHMARK_CAPTURE(BM_distance, DIST_300_k ## k, k, MID300_CHALLENGE); \
+BENCHMARK_CAPTURE(BM_distance, DIST_1285_k ## k, k, LONG_CHALLENGE);
+
+DEF_DISTANCE_BENCH(1);
+DEF_DISTANCE_BENCH(2);
+DEF_DISTANCE_BENCH(3);
+
+BENCHMARK_CAPTURE(BM_levenshtein, DIST_15_full, SHORT_CHALLENGE);
+BENCHMARK_CAPTURE(BM_levenshtein, DIST_45_full, MID_CHALLENGE);
+BENCHMARK_CAPTURE(BM_levenshtein, DIST_300_full, MID300_CHALLENGE);
+
+// the byte kernel is the reference cost, its verdicts differ on non-ASCII data
+#define DEF_UTF8_BENCH(name, alphabet) \
+BENCHMARK_CAPTURE(BM_utf8, UTF8_ ## name ## _utf8, oneChangeUtf8, alphabet)->Arg(15)->Arg(45)->Arg(300); \
+BENCHMARK_CAPTURE(BM_utf8, UTF8_ ## name ## _avxFast, oneChangeFastAVX, alphabet)->Arg(15)->Arg(45)->Arg(300);
+
+DEF_UTF8_BENCH(ascii, ASCII_NAMES);
+DEF_UTF8_BENCH(latin, LATIN_NAMES);
+DEF_UTF8_BENCH(cyrillic, CYRILLIC_NAMES);
+DEF_UTF8_BENCH(cjk, CJK_NAMES);
+DEF_UTF8_BENCH(mixed, MIXED_NAMES);
+
+#define DEF_BATCH_BENCH(name, challenge) \
+BENCHMARK_CAPTURE(BM_batch, BATCH_ ## name, challenge)->RangeMultiplier(16)->Range(16, 100000); \
+BENCHMARK_CAPTURE(BM_batchLoop, BATCH_LOOP_ ## name, challenge)->RangeMultiplier(16)->Range(16, 100000);
+
+DEF_BATCH_BENCH(15, SHORT_CHALLENGE);
+DEF_BATCH_BENCH(45, MID_CHALLENGE);
+DEF_BATCH_BENCH(300, MID300_CHALLENGE);
+
+BENCHMARK(BM_shortBatch)->ArgsProduct({{8, 12, 16}, {0, 1, 2}});
+BENCHMARK(BM_column)->ArgsProduct({{8, 45, 300}, {0, 1, 2}});
+BENCHMARK(BM_matcher)->Arg(0)->Arg(1500)->Arg(4096)->Arg(65536);
+BENCHMARK(BM_findOneEdit)->ArgsProduct({{8, 32, 128}, {0, 65536, 1024}, {0}});
+BENCHMARK(BM_findOneEdit)->Args({32, 0, 1})->Args({32, 1024, 1})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_indexBuild)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_indexQuery)->Arg(10000)->Arg(1000000);
+BENCHMARK(BM_scanQuery)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_selfJoin)->ArgsProduct({{10000, 1000000, 10000000}, {1, 2, 4, 8, 16}})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_selfJoinBruteForce)->Arg(10000)->Unit(benchmark::kMillisecond);
 
 BENCHMARK_CAPTURE(BM_memcmp, memcmp15, SHORT_CHALLENGE);
 BENCHMARK_CAPTURE(BM_memcmp, memcmpInf, INF_CHALLENGE);
+BENCHMARK_CAPTURE(BM_memcmpEq, memcmpEq1285, LONG_CHALLENGE);
+BENCHMARK_CAPTURE(BM_memcmpEq, memcmpEq10Kb, LONG10_CHALLENGE);
+BENCHMARK_CAPTURE(BM_memcmpEq, memcmpEq30Kb, LONG30_CHALLENGE);
+BENCHMARK_CAPTURE(BM_memcmpEq, memcmpEq120Kb, INF_CHALLENGE);
 
 BENCHMARK(BM_SIMDLoadAlign);
 BENCHMARK(BM_SIMDULoadAlign);
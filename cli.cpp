@@ -0,0 +1,168 @@
+// onechange-cli: checks (lhs \t rhs) lines of a file for being one edit apart.
+// The input is memory-mapped and handed to checkPairs() (pairs.h), which checks it in parallel on string_views
+// into the mapping and writes the results in input order.
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fn.h"
+#include "pairs.h"
+#include "pool.h"
+
+
+namespace {
+
+struct Options {
+    char const* input = nullptr;
+    char const* output = nullptr; // stdout if not set
+    PairOutput mode = PairOutput::Bitmap;
+    unsigned threads = std::thread::hardware_concurrency();
+};
+
+class MappedFile {
+public:
+    explicit MappedFile(char const* path) {
+        m_fd = open(path, O_RDONLY);
+        if (m_fd < 0) {
+            return;
+        }
+        struct stat st{};
+        if (fstat(m_fd, &st) != 0) {
+            return;
+        }
+        m_size = st.st_size;
+        if (m_size == 0) {
+            m_valid = true;
+            return;
+        }
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (data == MAP_FAILED) {
+            return;
+        }
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<char const*>(data);
+        m_valid = true;
+    }
+
+    ~MappedFile() {
+        if (m_data != nullptr) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    bool valid() const noexcept {
+        return m_valid;
+    }
+
+    std::string_view view() const noexcept {
+        return {m_data, m_size};
+    }
+
+private:
+    int m_fd = -1;
+    char const* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_valid = false;
+};
+
+void usage() {
+    fprintf(stderr,
+            "usage: onechange-cli [--threads N] [--mode bitmap|matches|rejects|none] [--out FILE] INPUT\n"
+            "  INPUT is lines of lhs<TAB>rhs, stats go to stderr\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue) {
+            const std::string_view value = argv[++i];
+            if (std::from_chars(value.data(), value.data() + value.size(), options.threads).ec != std::errc{}) {
+                return false;
+            }
+        } else if (arg == "--mode" && hasValue) {
+            const std::string_view value = argv[++i];
+            if (value == "bitmap") {
+                options.mode = PairOutput::Bitmap;
+            } else if (value == "matches") {
+                options.mode = PairOutput::Matches;
+            } else if (value == "rejects") {
+                options.mode = PairOutput::Rejects;
+            } else if (value == "none") {
+                options.mode = PairOutput::None;
+            } else {
+                return false;
+            }
+        } else if (arg == "--out" && hasValue) {
+            options.output = argv[++i];
+        } else if (!arg.starts_with("--") && options.input == nullptr) {
+            options.input = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return options.input != nullptr;
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    const MappedFile file(options.input);
+    if (!file.valid()) {
+        fprintf(stderr, "can't map %s: %s\n", options.input, strerror(errno));
+        return 1;
+    }
+    FILE* out = options.output != nullptr ? fopen(options.output, "wb") : stdout;
+    if (out == nullptr) {
+        fprintf(stderr, "can't open %s: %s\n", options.output, strerror(errno));
+        return 1;
+    }
+    setvbuf(out, nullptr, _IOFBF, 1 << 20);
+
+    const auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(options.threads);
+    const auto stats = checkPairs(file.view(), options.mode, out, pool);
+    // failed writes only set the error flag of out, the buffered rest is written by fflush()
+    int error = fflush(out) != 0 || ferror(out) ? errno : 0;
+    if (out != stdout && fclose(out) != 0 && error == 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        fprintf(stderr, "can't write %s: %s\n", options.output != nullptr ? options.output : "stdout",
+                strerror(error));
+        return 1;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const auto seconds = std::max(elapsed.count(), 1e-9);
+    fprintf(stderr, "pairs: %zu, one edit: %zu, malformed: %zu, kernel: %.*s\n", stats.pairs, stats.matches,
+            stats.malformed,
+            static_cast<int>(toString(oneChangeAutoLevel()).size()), toString(oneChangeAutoLevel()).data());
+    fprintf(stderr, "%.3f s, %.2f M pairs/s, %.2f GB/s\n", seconds, stats.pairs / seconds / 1e6,
+            file.view().size() / seconds / 1e9);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fn.h"
+
+
+// Arrow-style string column (the "utf8" layout): row i is data[offsets[i], offsets[i + 1]), offsets holds
+// size() + 1 entries and needn't start at 0 (a slice). A view over the caller's buffers, nothing is copied.
+// padding is the count of readable bytes after data: with ONECHANGE_PADDING or more the column-vs-column
+// kernels load tails without page-edge checks (see oneChangePadded()).
+class StringColumn {
+public:
+    using offset_t = int32_t;
+
+    StringColumn(std::span<const offset_t> offsets, std::string_view data, size_t padding = 0) noexcept
+        : m_offsets(offsets)
+        , m_data(data.data())
+        , m_padding(padding) {
+        assert(!offsets.empty() && static_cast<size_t>(offsets.back()) <= data.size());
+        // rows at the end of data are followed by the rest of the buffer too
+        m_padding += data.size() - static_cast<size_t>(offsets.back());
+    }
+
+    std::string_view operator[](size_t i) const noexcept {
+        return {m_data + m_offsets[i], static_cast<size_t>(m_offsets[i + 1] - m_offsets[i])};
+    }
+
+    size_t size() const noexcept {
+        return m_offsets.size() - 1;
+    }
+
+    bool padded() const noexcept {
+        return m_padding >= ONECHANGE_PADDING;
+    }
+
+    // first byte of row i, i <= size()
+    const char* row(size_t i) const noexcept {
+        return m_data + m_offsets[i];
+    }
+
+private:
+    std::span<const offset_t> m_offsets;
+    const char* m_data;
+    size_t m_padding;
+};
+
+// Owns the buffers of a padded StringColumn: the data is followed by ONECHANGE_PADDING zero bytes
+class StringColumnBuilder {
+public:
+    StringColumnBuilder()
+        : m_data(ONECHANGE_PADDING, '\0') {
+    }
+
+    void append(std::string_view str) {
+        m_data.insert(m_data.size() - ONECHANGE_PADDING, str);
+        m_offsets.push_back(static_cast<StringColumn::offset_t>(m_data.size() - ONECHANGE_PADDING));
+    }
+
+    // valid until the next append()
+    StringColumn column() const noexcept {
+        return {m_offsets, {m_data.data(), m_data.size() - ONECHANGE_PADDING}, ONECHANGE_PADDING};
+    }
+
+private:
+    std::vector<StringColumn::offset_t> m_offsets{0};
+    std::string m_data;
+};
+
+// Bit i % 64 of out[i / 64] is oneChange(lhs[i], rhs[i]) (an LSB-first validity-style bitmap), returns the count
+// of set bits. Both buffers are streamed in row order through the size-specialized kernels of oneChangeAutoLevel().
+// lhs.size() == rhs.size(), out.size() * 64 >= lhs.size()
+size_t oneChangeColumn(StringColumn const& lhs, StringColumn const& rhs, std::span<uint64_t> out) noexcept;
+// Bit i is oneChange(column[i], query): the oneChangeBatch() scan with the query head kept in a register
+size_t oneChangeColumn(StringColumn const& column, std::string_view query, std::span<uint64_t> out) noexcept;
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <immintrin.h>
+
+#include "fn.h"
+#include "kernels.h"
+#include "simd.h"
+
+
+unsigned editDistanceSlow(std::string_view lhs, std::string_view rhs) noexcept {
+    std::vector<unsigned> row(rhs.size() + 1);
+    for (size_t j = 0; j != row.size(); ++j) {
+        row[j] = j;
+    }
+
+    for (size_t i = 0; i != lhs.size(); ++i) {
+        unsigned diagonal = row[0];
+        row[0] = i + 1;
+        for (size_t j = 0; j != rhs.size(); ++j) {
+            const auto replace = diagonal + (lhs[i] != rhs[j]);
+            diagonal = row[j + 1];
+            row[j + 1] = std::min({replace, row[j] + 1, row[j + 1] + 1});
+        }
+    }
+    return row.back();
+}
+
+
+namespace {
+
+// Myers/Hyyro bit-parallel column of the global edit distance matrix for a pattern of size <= 64.
+// Bit i of pv/mv is +1/-1 vertical delta at row i, score is the value at the last row.
+struct MyersColumn {
+    uint64_t pv = ~0ull;
+    uint64_t mv = 0;
+    uint64_t last;
+    unsigned score;
+
+    explicit MyersColumn(size_t patternSize) noexcept
+        : last(1ull << (patternSize - 1))
+        , score(patternSize) {
+    }
+
+    // eq: bit i is set if pattern[i] equals the next text symbol
+    void advance(uint64_t eq) noexcept {
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        score += (ph & last) != 0;
+        score -= (mh & last) != 0;
+        ph = (ph << 1) | 1; // the first row is 0, 1, 2, ... for global distance
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+};
+
+// text.size() >= pattern.size(), 0 < pattern.size() <= 64
+template <typename EqFn>
+bool myersWithin(std::string_view text, size_t patternSize, unsigned k, EqFn&& eqFn) noexcept {
+    MyersColumn column(patternSize);
+    const auto textSize = text.size();
+    for (size_t j = 0; j != textSize; ++j) {
+        column.advance(eqFn(text[j]));
+        // each remaining text symbol can lower the last row by one at most
+        if (column.score > k + (textSize - j - 1)) {
+            return false;
+        }
+    }
+    return column.score <= k;
+}
+
+bool myersWithinScalar(std::string_view text, std::string_view pattern, unsigned k) noexcept {
+    std::array<uint64_t, 256> peq{};
+    for (size_t i = 0; i != pattern.size(); ++i) {
+        peq[static_cast<unsigned char>(pattern[i])] |= 1ull << i;
+    }
+    return myersWithin(text, pattern.size(), k, [&](char c) noexcept {
+        return peq[static_cast<unsigned char>(c)];
+    });
+}
+
+ONECHANGE_TARGET_AVX2_BEGIN
+bool myersWithinAVX2(std::string_view text, std::string_view pattern, unsigned k) noexcept {
+    alignas(32) char buffer[64] = {};
+    memcpy(buffer, pattern.data(), pattern.size());
+    const __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(buffer));
+    const __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i*>(buffer + 32));
+    const uint64_t patternMask = _bzhi_u64(~0ull, pattern.size());
+    return myersWithin(text, pattern.size(), k, [&](char c) noexcept {
+        const __m256i symbol = _mm256_set1_epi8(c);
+        const uint64_t eqLo = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, symbol)));
+        const uint64_t eqHi = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, symbol)));
+        return (eqLo | (eqHi << 32)) & patternMask;
+    });
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+bool myersWithinAVX512(std::string_view text, std::string_view pattern, unsigned k) noexcept {
+    const __mmask64 patternMask = _bzhi_u64(~0ull, pattern.size());
+    const __m512i patternVec = _mm512_maskz_loadu_epi8(patternMask, pattern.data());
+    return myersWithin(text, pattern.size(), k, [&](char c) noexcept {
+        return _mm512_mask_cmpeq_epi8_mask(patternMask, patternVec, _mm512_set1_epi8(c));
+    });
+}
+ONECHANGE_TARGET_END
+
+// Landau-Vishkin: wave e keeps the furthest row reachable on every diagonal |d| <= e with e edits,
+// rows are slid along the diagonal with a SIMD common extension, O(k^2) extensions overall
+bool diagonalWithin(std::string_view text, std::string_view pattern, unsigned k, ExtensionFn lce) noexcept {
+    using row_t = ptrdiff_t;
+    constexpr row_t NONE = std::numeric_limits<row_t>::min() / 2;
+    const auto n = static_cast<row_t>(text.size());
+    const auto m = static_cast<row_t>(pattern.size());
+    const row_t target = n - m;
+    const row_t maxDiagonal = k;
+
+    row_t stack[2 * (2 * 8 + 1)];
+    std::vector<row_t> heap;
+    row_t* prev = stack;
+    const size_t width = 2 * size_t{k} + 1;
+    if (k > 8) {
+        heap.resize(2 * width);
+        prev = heap.data();
+    }
+    row_t* cur = prev + width;
+    // i-th row on diagonal d is the (i, i + d) cell
+    const auto slide = [&](row_t i, row_t d) noexcept {
+        const auto limit = std::min(m - i, n - i - d);
+        return i + static_cast<row_t>(lce(pattern.data() + i, text.data() + i + d, limit));
+    };
+
+    prev[maxDiagonal] = slide(0, 0);
+    if (target == 0 && prev[maxDiagonal] == m) {
+        return true;
+    }
+
+    for (row_t e = 1; e <= maxDiagonal; ++e) {
+        for (row_t d = -e; d <= e; ++d) {
+            row_t row = NONE;
+            if (std::abs(d) < e) {
+                row = prev[maxDiagonal + d] + 1;
+            }
+            if (std::abs(d + 1) < e) {
+                row = std::max(row, prev[maxDiagonal + d + 1] + 1);
+            }
+            if (std::abs(d - 1) < e) {
+                row = std::max(row, prev[maxDiagonal + d - 1]);
+            }
+            row = std::min({row, m, n - d});
+            if (row < std::max<row_t>(0, -d)) {
+                cur[maxDiagonal + d] = NONE;
+                continue;
+            }
+
+            row = slide(row, d);
+            cur[maxDiagonal + d] = row;
+            if (d == target && row == m) {
+                return true;
+            }
+        }
+        std::swap(prev, cur);
+    }
+
+    return false;
+}
+
+}
+
+
+namespace {
+
+struct DistanceEngine {
+    ExtensionFn lce;
+    ExtensionFn rlce;
+    bool (*myers)(std::string_view text, std::string_view pattern, unsigned k) noexcept;
+};
+
+// indexed by SimdLevel
+constexpr DistanceEngine DISTANCE_ENGINES[] = {
+        {lceScalar, rlceScalar, myersWithinScalar},
+        {lceSSE, rlceSSE, myersWithinScalar},
+        {lceAVX2, rlceAVX2, myersWithinAVX2},
+        {lceAVX512, rlceAVX512, myersWithinAVX512},
+};
+
+}
+
+bool withinEditDistance(std::string_view lhs, std::string_view rhs, unsigned k) noexcept {
+    if (k == 0) {
+        return lhs == rhs;
+    } else if (k == 1) {
+        return oneChangeAuto(lhs, rhs);
+    }
+
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() - rhs.size() > k) {
+        return false;
+    } else if (k >= lhs.size()) {
+        // the distance is at most the longer size
+        return true;
+    }
+
+    auto const& engine = DISTANCE_ENGINES[static_cast<unsigned>(oneChangeAutoLevel())];
+    const auto prefix = engine.lce(lhs.data(), rhs.data(), rhs.size());
+    lhs.remove_prefix(prefix);
+    rhs.remove_prefix(prefix);
+    const auto suffix = engine.rlce(lhs.data() + lhs.size(), rhs.data() + rhs.size(), rhs.size());
+    lhs.remove_suffix(suffix);
+    rhs.remove_suffix(suffix);
+
+    if (rhs.empty()) {
+        return lhs.size() <= k;
+    } else if (rhs.size() == 1) {
+        // the rest of the longer string is inserted, the symbol is either found or replaced
+        return lhs.size() - (lhs.find(rhs[0]) != std::string_view::npos) <= k;
+    }
+
+    // the waves are sized for the trimmed core
+    k = static_cast<unsigned>(std::min<size_t>(k, lhs.size()));
+    if (rhs.size() > 64) {
+        return diagonalWithin(lhs, rhs, k, engine.lce);
+    }
+    return engine.myers(lhs, rhs, k);
+}
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <immintrin.h>
+
+#include "fn.h"
+#include "kernels.h"
+#include "simd.h"
+
+
+size_t lceScalar(char const* lhs, char const* rhs, size_t size) noexcept {
+    return std::mismatch(lhs, lhs + size, rhs).first - lhs;
+}
+
+size_t rlceScalar(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    while (i != size && lhs[-1 - static_cast<ptrdiff_t>(i)] == rhs[-1 - static_cast<ptrdiff_t>(i)]) {
+        ++i;
+    }
+    return i;
+}
+
+ONECHANGE_TARGET_SSE_BEGIN
+size_t lceSSE(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target));
+        if (mask != 0xffff) {
+            return i + std::countr_one(mask);
+        }
+    }
+    if (i == size || size < 16) {
+        return i + lceScalar(lhs + i, rhs + i, size - i);
+    }
+    // the last block overlaps the compared (equal) bytes
+    __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + size - 16));
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + size - 16));
+    return size - 16 + std::countr_one(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target))));
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_SSE_BEGIN
+size_t rlceSSE(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs - i - 16));
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs - i - 16));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target));
+        if (mask != 0xffff) {
+            return i + std::countl_one(static_cast<uint16_t>(mask));
+        }
+    }
+    if (i == size || size < 16) {
+        return i + rlceScalar(lhs - i, rhs - i, size - i);
+    }
+    // the first block overlaps the compared (equal) bytes
+    __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs - size));
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs - size));
+    return size - 16 + std::countl_one(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target))));
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX2_BEGIN
+size_t rlceAVX2(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs - i - 32));
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs - i - 32));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target));
+        if (mask != 0xffffffff) {
+            return i + std::countl_zero(~mask);
+        }
+    }
+    if (i == size || size < 32) {
+        return i + rlceSSE(lhs - i, rhs - i, size - i);
+    }
+    __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs - size));
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs - size));
+    return size - 32 + std::countl_one(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target))));
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX2_BEGIN
+size_t lceAVX2(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target));
+        if (mask != 0xffffffff) {
+            return i + std::countr_zero(~mask);
+        }
+    }
+    if (i == size || size < 32) {
+        return i + lceSSE(lhs + i, rhs + i, size - i);
+    }
+    __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + size - 32));
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + size - 32));
+    return size - 32 + std::countr_one(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target))));
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+size_t rlceAVX512(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i target = _mm512_loadu_si512(lhs - i - 64);
+        __m512i chunk = _mm512_loadu_si512(rhs - i - 64);
+        const __mmask64 errors = _mm512_cmpneq_epi8_mask(chunk, target);
+        if (errors != 0) {
+            return i + std::countl_zero(errors);
+        }
+    }
+    if (i == size) {
+        return size;
+    }
+    // the rest is the top of a masked block, masked-out bytes are never read
+    const __mmask64 mask = ~_bzhi_u64(~0ull, 64 - (size - i));
+    __m512i target = _mm512_maskz_loadu_epi8(mask, lhs - i - 64);
+    __m512i chunk = _mm512_maskz_loadu_epi8(mask, rhs - i - 64);
+    const __mmask64 errors = _mm512_mask_cmpneq_epi8_mask(mask, chunk, target);
+    return errors != 0 ? i + std::countl_zero(errors) : size;
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+size_t lceAVX512(char const* lhs, char const* rhs, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m512i target = _mm512_loadu_si512(lhs + i);
+        __m512i chunk = _mm512_loadu_si512(rhs + i);
+        const __mmask64 errors = _mm512_cmpneq_epi8_mask(chunk, target);
+        if (errors != 0) {
+            return i + std::countr_zero(errors);
+        }
+    }
+    if (i == size) {
+        return size;
+    }
+    const __mmask64 mask = _bzhi_u64(~0ull, size - i);
+    __m512i target = _mm512_maskz_loadu_epi8(mask, lhs + i);
+    __m512i chunk = _mm512_maskz_loadu_epi8(mask, rhs + i);
+    const __mmask64 errors = _mm512_mask_cmpneq_epi8_mask(mask, chunk, target);
+    return errors != 0 ? i + std::countr_zero(errors) : size;
+}
+ONECHANGE_TARGET_END
+
+
+
+namespace {
+
+struct ExtensionEngine {
+    ExtensionFn lce;
+    ExtensionFn rlce;
+};
+
+// indexed by SimdLevel
+constexpr ExtensionEngine EXTENSION_ENGINES[] = {
+        {lceScalar, rlceScalar},
+        {lceSSE, rlceSSE},
+        {lceAVX2, rlceAVX2},
+        {lceAVX512, rlceAVX512},
+};
+
+ExtensionEngine const& extensionEngine() noexcept {
+    return EXTENSION_ENGINES[static_cast<unsigned>(oneChangeAutoLevel())];
+}
+
+// Below this size handing one end over to the helper thread costs more than scanning it
+constexpr size_t PARALLEL_SIZE = 64 << 10;
+// Progress of a side is published once per block
+constexpr size_t BLOCK_SIZE = 4 << 10;
+
+struct EndScan {
+    std::atomic<size_t> length{0};
+    std::atomic<bool> done{false};
+};
+
+struct EndJob {
+    ExtensionFn extend;
+    char const* lhs;
+    char const* rhs;
+    ptrdiff_t direction; // 1 for the prefix, -1 for the suffix from the ends
+    size_t size;
+    size_t need;
+    EndScan* self;
+    EndScan const* other;
+};
+
+// Extends one end block by block until a mismatch or until both ends together cover `need` bytes
+void scanEnd(EndJob const& job) noexcept {
+    size_t length = 0;
+    while (length != job.size && length + job.other->length.load(std::memory_order_relaxed) < job.need) {
+        const auto step = std::min(BLOCK_SIZE, job.size - length);
+        const auto offset = job.direction * static_cast<ptrdiff_t>(length);
+        const auto equal = job.extend(job.lhs + offset, job.rhs + offset, step);
+        length += equal;
+        job.self->length.store(length, std::memory_order_relaxed);
+        if (equal != step) {
+            break;
+        }
+    }
+    job.self->done.store(true, std::memory_order_release);
+    job.self->done.notify_one();
+}
+
+// Single long-living thread for the suffix side, one call at a time
+class EndHelper {
+public:
+    EndHelper()
+        : m_thread([this]() { run(); }) {
+    }
+
+    ~EndHelper() {
+        m_stop.store(true, std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+        m_generation.notify_one();
+        m_thread.join();
+    }
+
+    // false if another call owns the helper
+    bool tryStart(EndJob const& job) noexcept {
+        if (!m_busy.try_lock()) {
+            return false;
+        }
+        m_job = job;
+        m_generation.fetch_add(1, std::memory_order_release);
+        m_generation.notify_one();
+        return true;
+    }
+
+    void finish(EndScan const& scan) noexcept {
+        scan.done.wait(false, std::memory_order_acquire);
+        m_busy.unlock();
+    }
+
+private:
+    void run() noexcept {
+        unsigned seen = 0;
+        while (true) {
+            m_generation.wait(seen, std::memory_order_acquire);
+            seen = m_generation.load(std::memory_order_acquire);
+            if (m_stop.load(std::memory_order_relaxed)) {
+                return;
+            }
+            scanEnd(m_job);
+        }
+    }
+
+    std::mutex m_busy;
+    EndJob m_job{};
+    std::atomic<unsigned> m_generation{0};
+    std::atomic<bool> m_stop{false};
+    std::thread m_thread;
+};
+
+std::unique_ptr<EndHelper> makeEndHelper() noexcept {
+    try {
+        return std::make_unique<EndHelper>();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+EndHelper* endHelper() noexcept {
+    static const auto helper = makeEndHelper();
+    return helper.get();
+}
+
+}
+
+size_t commonPrefix(std::string_view lhs, std::string_view rhs) noexcept {
+    return extensionEngine().lce(lhs.data(), rhs.data(), std::min(lhs.size(), rhs.size()));
+}
+
+size_t commonSuffix(std::string_view lhs, std::string_view rhs) noexcept {
+    return extensionEngine().rlce(lhs.data() + lhs.size(), rhs.data() + rhs.size(),
+                                  std::min(lhs.size(), rhs.size()));
+}
+
+bool oneChangeTwoEnded(std::string_view lhs, std::string_view rhs) noexcept {
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() - rhs.size() > 1) {
+        return false;
+    } else if (rhs.empty()) {
+        return true;
+    }
+
+    // bytes outside of the one replaced (same size) or inserted (diff size) symbol
+    const size_t need = rhs.size() - (lhs.size() == rhs.size());
+    auto const& engine = extensionEngine();
+    const auto prefix = engine.lce(lhs.data(), rhs.data(), rhs.size());
+    if (prefix >= need) {
+        return true;
+    }
+    const auto suffix = engine.rlce(lhs.data() + lhs.size(), rhs.data() + rhs.size(), need - prefix);
+    return prefix + suffix >= need;
+}
+
+bool oneChangeTwoEndedParallel(std::string_view lhs, std::string_view rhs) noexcept {
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() - rhs.size() > 1 || rhs.size() < PARALLEL_SIZE) {
+        return oneChangeTwoEnded(lhs, rhs);
+    }
+    auto* helper = endHelper();
+    if (helper == nullptr) {
+        return oneChangeTwoEnded(lhs, rhs);
+    }
+
+    const size_t need = rhs.size() - (lhs.size() == rhs.size());
+    auto const& engine = extensionEngine();
+    EndScan prefix, suffix;
+    const EndJob suffixJob{engine.rlce, lhs.data() + lhs.size(), rhs.data() + rhs.size(), -1,
+                           rhs.size(), need, &suffix, &prefix};
+    if (!helper->tryStart(suffixJob)) {
+        return oneChangeTwoEnded(lhs, rhs);
+    }
+    scanEnd({engine.lce, lhs.data(), rhs.data(), 1, rhs.size(), need, &prefix, &suffix});
+    helper->finish(suffix);
+
+    return prefix.length.load(std::memory_order_relaxed) + suffix.length.load(std::memory_order_relaxed) >= need;
+}
+
+static bool isContinuation(char c) noexcept {
+    return (static_cast<unsigned char>(c) & 0xc0) == 0x80;
+}
+
+ONECHANGE_TARGET_AVX512_BEGIN
+// bits [from, to) of a 64-bit mask, to <= 64
+static __mmask64 bitRange(size_t from, size_t to) noexcept {
+    return _bzhi_u64(~0ull, to) & ~_bzhi_u64(~0ull, from);
+}
+
+static __mmask64 continuationBytes(__m512i bytes, __mmask64 mask) noexcept {
+    return _mm512_mask_cmpeq_epi8_mask(mask, _mm512_and_si512(bytes, _mm512_set1_epi8(0xc0)),
+                                       _mm512_set1_epi8(static_cast<char>(0x80)));
+}
+
+// lhs is the longer one, both fit one block: the differing window comes from a head-aligned and an end-aligned
+// compare, it's moved out to the code point boundaries with the continuation byte masks
+static bool oneChangeUtf8AVX512(std::string_view lhs, std::string_view rhs) noexcept {
+    const auto n = lhs.size();
+    const auto m = rhs.size();
+    const auto shift = n - m;
+    const __mmask64 lhsMask = _bzhi_u64(~0ull, n);
+    const __mmask64 rhsMask = _bzhi_u64(~0ull, m);
+    const __mmask64 rhsEndMask = rhsMask << shift;
+    const __m512i l = _mm512_maskz_loadu_epi8(lhsMask, lhs.data());
+    const __m512i r = _mm512_maskz_loadu_epi8(rhsMask, rhs.data());
+    const __m512i rEnd = _mm512_maskz_loadu_epi8(rhsEndMask, rhs.data() - shift);
+
+    const __mmask64 head = _mm512_mask_cmpneq_epi8_mask(rhsMask, l, r);
+    const __mmask64 tail = _mm512_mask_cmpneq_epi8_mask(rhsEndMask, l, rEnd);
+    if (head == 0 && shift == 0) {
+        return true;
+    }
+    const size_t prefix = head == 0 ? m : std::countr_zero(head);
+    const __mmask64 lhsContinuation = continuationBytes(l, lhsMask);
+    const __mmask64 rhsContinuation = continuationBytes(r, rhsMask);
+    const __mmask64 boundaries = ~(lhsContinuation | rhsContinuation) & bitRange(0, prefix + 1);
+    const size_t begin = boundaries == 0 ? 0 : 63 - std::countl_zero(boundaries);
+
+    // first byte of the common suffix in lhs, the suffix doesn't overlap the prefix
+    size_t end = tail == 0 ? shift : 64 - std::countl_zero(tail);
+    end = std::max(end, begin + shift);
+    const __mmask64 lhsEnds = ~lhsContinuation & lhsMask & ~_bzhi_u64(~0ull, end);
+    end = lhsEnds == 0 ? n : std::countr_zero(lhsEnds);
+
+    return std::popcount(~lhsContinuation & bitRange(begin, end)) <= 1
+           && std::popcount(~rhsContinuation & bitRange(begin, end - shift)) <= 1;
+}
+ONECHANGE_TARGET_END
+
+bool oneChangeUtf8(std::string_view lhs, std::string_view rhs) noexcept {
+    constexpr size_t MAX_CODE_POINT = 4;
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() - rhs.size() > MAX_CODE_POINT) {
+        return false;
+    }
+
+    const auto level = oneChangeAutoLevel();
+    if (level == SimdLevel::AVX512 && lhs.size() <= 64) {
+        return oneChangeUtf8AVX512(lhs, rhs);
+    }
+
+    // differing bytes are [prefix, lhs.size() - suffix) and [prefix, rhs.size() - suffix),
+    // both ends are moved out to the code point boundaries
+    auto const& engine = EXTENSION_ENGINES[static_cast<unsigned>(level)];
+    const auto minSize = rhs.size();
+    auto prefix = engine.lce(lhs.data(), rhs.data(), minSize);
+    while (prefix != 0 && ((prefix < lhs.size() && isContinuation(lhs[prefix]))
+                           || (prefix < rhs.size() && isContinuation(rhs[prefix])))) {
+        --prefix;
+    }
+    auto suffix = engine.rlce(lhs.data() + lhs.size(), rhs.data() + rhs.size(), minSize - prefix);
+    while (suffix != 0 && isContinuation(lhs[lhs.size() - suffix])) {
+        --suffix;
+    }
+
+    const auto lhsWindow = lhs.substr(prefix, lhs.size() - suffix - prefix);
+    const auto rhsWindow = rhs.substr(prefix, rhs.size() - suffix - prefix);
+    if (lhsWindow.size() > MAX_CODE_POINT || rhsWindow.size() > MAX_CODE_POINT) {
+        return false;
+    }
+    const auto codePoints = [](std::string_view window) noexcept {
+        return std::count_if(window.begin(), window.end(), [](char c) noexcept { return !isContinuation(c); });
+    };
+    return codePoints(lhsWindow) <= 1 && codePoints(rhsWindow) <= 1;
+}
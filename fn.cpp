@@ -4,6 +4,16 @@
 #include <cassert>
 #include <bit>
 #include <cstring>
+#include <atomic>
+#include <cstdlib>
+#include <cpuid.h>
+#include <algorithm>
+#include <iterator>
+
+#include "fn.h"
+#include "kernels.h"
+#include "simd.h"
+#include "telemetry.h"
 
 
 using it = std::string_view::const_iterator;
@@ -97,6 +107,7 @@ bool oneChangeNoSIMDFast(std::string_view lhs, std::string_view rhs) noexcept {
     }
 }
 
+ONECHANGE_TARGET_SSE_BEGIN
 unsigned popcount(__m128i v) noexcept {
     const __m128i lookup = _mm_setr_epi8(
             /* 0 */ 0, /* 1 */ 1, /* 2 */ 1, /* 3 */ 2,
@@ -112,8 +123,10 @@ unsigned popcount(__m128i v) noexcept {
     auto result = _mm_sad_epu8(_mm_add_epi8(popcnt1, popcnt2), _mm_setzero_si128());
     return _mm_extract_epi64(result, 0) + _mm_extract_epi64(result, 1);
 }
+ONECHANGE_TARGET_END
 
 
+ONECHANGE_TARGET_AVX2_BEGIN
 unsigned popcount(__m256i v) noexcept {
     const __m256i mask1 = _mm256_set1_epi64x(0x5555555555555555LL);
     const __m256i mask2 = _mm256_set1_epi64x(0x3333333333333333LL);
@@ -137,89 +150,667 @@ unsigned popcount(__m256i v) noexcept {
 
     return count;
 }
+ONECHANGE_TARGET_END
+
+// Tails of the Fast kernels (< 16/32 bytes) are compared with 16-byte loads instead of a byte loop.
+// A tail of 16+ bytes is a head load plus an overlapping load of its last 16 bytes, a shorter one reads 16 bytes
+// and masks off the bytes past the end: such a read can't fault while it stays in the page of its first byte.
+// Only at page edges the bytes are staged on the stack.
+struct PageSafeTail {
+    static bool overRead(it p) noexcept {
+        return (reinterpret_cast<uintptr_t>(p) & (ONECHANGE_PAGE_SIZE - 1)) <= ONECHANGE_PAGE_SIZE - 16;
+    }
+};
+
+// The caller guarantees ONECHANGE_PADDING readable bytes after the strings, see oneChangePadded()
+struct PaddedTail {
+    static constexpr bool overRead(it) noexcept {
+        return true;
+    }
+};
+
+// Byte equivalence policies of the Fast kernels: bytes a and b are equal if fold(a) == fold(b).
+// Both sides are folded in registers right before the compare. fold() is given for a byte, a 64-bit SWAR word,
+// a 16-byte vector (SSE2 only, tails use it from any level) and, in the regions below, 32/64-byte vectors.
+static constexpr uint64_t SWAR_LOW7 = 0x7f7f7f7f7f7f7f7full;
+static constexpr uint64_t SWAR_HIGH = ~SWAR_LOW7;
+
+static constexpr uint64_t swarBytes(unsigned char c) noexcept {
+    return 0x0101010101010101ull * c;
+}
+
+struct ExactBytes {
+    static constexpr char fold(char c) noexcept { return c; }
+    static constexpr uint64_t fold(uint64_t v) noexcept { return v; }
+    static __m128i fold(__m128i v) noexcept { return v; }
+    static __m256i fold(__m256i v) noexcept;
+    static __m512i fold(__m512i v) noexcept;
+};
+
+struct AsciiCaseFold {
+    static constexpr char fold(char c) noexcept { return c >= 'A' && c <= 'Z' ? char(c | 0x20) : c; }
+    static constexpr uint64_t fold(uint64_t v) noexcept {
+        // high bit of a byte: its low 7 bits are >= 'A' and not > 'Z', and the byte itself is < 0x80
+        const uint64_t low = v & SWAR_LOW7;
+        const uint64_t upper = (low + swarBytes(0x80 - 'A')) & ~(low + swarBytes(0x7f - 'Z')) & ~v & SWAR_HIGH;
+        return v | (upper >> 2);
+    }
+    static __m128i fold(__m128i v) noexcept {
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                            _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    }
+    static __m256i fold(__m256i v) noexcept;
+    static __m512i fold(__m512i v) noexcept;
+};
+
+struct DashUnderscoreFold {
+    static constexpr char fold(char c) noexcept { return c == '_' ? '-' : c; }
+    static constexpr uint64_t fold(uint64_t v) noexcept {
+        const uint64_t diff = v ^ swarBytes('_');
+        const uint64_t underscore = ~(((diff & SWAR_LOW7) + SWAR_LOW7) | diff) & SWAR_HIGH;
+        return v ^ ((underscore >> 7) * ('_' ^ '-'));
+    }
+    static __m128i fold(__m128i v) noexcept {
+        const __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        return _mm_xor_si128(v, _mm_and_si128(underscore, _mm_set1_epi8('_' ^ '-')));
+    }
+    static __m256i fold(__m256i v) noexcept;
+    static __m512i fold(__m512i v) noexcept;
+};
+
+template <typename... Folds>
+struct FoldAll {
+    static constexpr char fold(char c) noexcept {
+        ((c = Folds::fold(c)), ...);
+        return c;
+    }
+    static constexpr uint64_t fold(uint64_t v) noexcept {
+        ((v = Folds::fold(v)), ...);
+        return v;
+    }
+    static __m128i fold(__m128i v) noexcept {
+        ((v = Folds::fold(v)), ...);
+        return v;
+    }
+    static __m256i fold(__m256i v) noexcept;
+    static __m512i fold(__m512i v) noexcept;
+};
+
+ONECHANGE_TARGET_AVX2_BEGIN
+inline __m256i ExactBytes::fold(__m256i v) noexcept {
+    return v;
+}
+
+inline __m256i AsciiCaseFold::fold(__m256i v) noexcept {
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
 
-unsigned countOfErrors(__m128i v) noexcept {
-    unsigned mask = _mm_movemask_epi8(v);
-    return 16 - std::popcount(mask);
+inline __m256i DashUnderscoreFold::fold(__m256i v) noexcept {
+    const __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return _mm256_xor_si256(v, _mm256_and_si256(underscore, _mm256_set1_epi8('_' ^ '-')));
 }
 
+template <typename... Folds>
+inline __m256i FoldAll<Folds...>::fold(__m256i v) noexcept {
+    ((v = Folds::fold(v)), ...);
+    return v;
+}
+ONECHANGE_TARGET_END
 
-unsigned countOfErrors(__m256i v) noexcept {
-    unsigned mask = _mm256_movemask_epi8(v);
-    return 32 - std::popcount(mask);
+ONECHANGE_TARGET_AVX512_BEGIN
+inline __m512i ExactBytes::fold(__m512i v) noexcept {
+    return v;
 }
 
-unsigned findFirstError(unsigned int mask) noexcept {
-    return _tzcnt_u32(~mask);
+inline __m512i AsciiCaseFold::fold(__m512i v) noexcept {
+    const __mmask64 upper = _mm512_cmple_epu8_mask(_mm512_sub_epi8(v, _mm512_set1_epi8('A')),
+                                                   _mm512_set1_epi8('Z' - 'A'));
+    return _mm512_mask_add_epi8(v, upper, v, _mm512_set1_epi8(0x20));
 }
 
+inline __m512i DashUnderscoreFold::fold(__m512i v) noexcept {
+    return _mm512_mask_mov_epi8(v, _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('_')), _mm512_set1_epi8('-'));
+}
 
-bool oneChange(std::string_view lhs, std::string_view rhs) noexcept {
-    if (lhs.size() < rhs.size()) {
-        return oneChange(rhs, lhs);
+template <typename... Folds>
+inline __m512i FoldAll<Folds...>::fold(__m512i v) noexcept {
+    ((v = Folds::fold(v)), ...);
+    return v;
+}
+ONECHANGE_TARGET_END
+
+// bit i is set if lb[i] != rb[i], 16 bytes of both are read
+template <typename Fold>
+inline uint32_t errors16(it lb, it rb) noexcept {
+    __m128i target = Fold::fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lb)));
+    __m128i chunk = Fold::fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rb)));
+    return ~_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target)) & 0xffff;
+}
+
+// page edge: errors16() of the first size < 16 bytes copied to the stack
+template <typename Fold>
+[[gnu::cold, gnu::noinline]] static uint32_t stagedErrors16(it lb, it rb, size_t size) noexcept {
+    ONECHANGE_COUNT(stagedTails);
+    char lhs[16] = {};
+    char rhs[16] = {};
+    memcpy(lhs, lb, size);
+    memcpy(rhs, rb, size);
+    return errors16<Fold>(lhs, rhs);
+}
+
+// bit i is set if lb[i] != rb[i] for i < size <= 32; elements of T are compared as their sizeof(T) bytes
+template <typename Tail, typename Fold, typename T>
+[[gnu::always_inline]] inline uint32_t tailErrors(T const* lhs, T const* rhs, size_t count) noexcept {
+    const auto lb = reinterpret_cast<it>(lhs);
+    const auto rb = reinterpret_cast<it>(rhs);
+    const auto size = count * sizeof(T);
+    assert(size <= 32);
+    if (size >= 16) {
+        return errors16<Fold>(lb, rb) | (errors16<Fold>(lb + size - 16, rb + size - 16) << (size - 16));
+    } else if (size == 0) {
+        return 0;
     }
 
-    const auto maxSize = lhs.size();
-    const auto minSize = rhs.size();
-    if (maxSize - minSize > 1) {
-        return false;
+    const uint32_t mask = (1u << size) - 1;
+    if (Tail::overRead(lb) && Tail::overRead(rb)) [[likely]] {
+        return errors16<Fold>(lb, rb) & mask;
     }
+    return stagedErrors16<Fold>(lb, rb, size) & mask;
+}
 
-    const bool oneSize = maxSize == minSize;
-    bool oneError = false;
 
-    const auto slow = [&oneError](it lb, it le, it rb, it re) noexcept {
-        const size_t size = re - rb;
-        const auto oneSizeLocal = (re - rb) == (le - lb);
-        for (size_t i = 0; i != size; ++i) {
-            if (lb[i + (oneError && !oneSizeLocal)] != rb[i]) {
-                if (std::exchange(oneError, true)) {
-                    return false;
+// Vector traits of the Fast kernels, one per SimdLevel. A block is WIDTH bytes: errors() has bit i set
+// if the folded lb[i] != rb[i], tail() is the same for size < WIDTH bytes without reading past the page.
+// equalGroup() compares GROUP bytes (several blocks) with the compares combined before the one test.
+// The kernels below are written once against these and instantiated in the target region of each level.
+// errors() and tail() also take 16/32-bit elements (ExactBytes only): element i then sets bits from
+// i * BITS<T> on, and size counts elements.
+struct VecSWAR {
+    static constexpr size_t WIDTH = 8;
+    static constexpr size_t GROUP = 4 * WIDTH;
+    template <typename T>
+    static constexpr unsigned BITS = sizeof(T);
+
+    template <typename Fold, typename T>
+    [[gnu::always_inline]] static uint32_t errors(T const* lb, T const* rb) noexcept {
+        uint64_t target, chunk;
+        memcpy(&target, lb, 8);
+        memcpy(&chunk, rb, 8);
+        const uint64_t diff = Fold::fold(target) ^ Fold::fold(chunk);
+        // high bit of every non-zero byte, gathered into the top byte by the multiply (no carries)
+        const uint64_t nonZero = (((diff & SWAR_LOW7) + SWAR_LOW7) | diff) & SWAR_HIGH;
+        return ((nonZero >> 7) * 0x0102040810204080ull) >> 56;
+    }
+
+    template <typename Fold>
+    [[gnu::always_inline]] static bool equalGroup(it lb, it rb) noexcept {
+        uint64_t diff = 0;
+        for (size_t k = 0; k != GROUP; k += WIDTH) {
+            uint64_t target, chunk;
+            memcpy(&target, lb + k, 8);
+            memcpy(&chunk, rb + k, 8);
+            diff |= Fold::fold(target) ^ Fold::fold(chunk);
+        }
+        return diff == 0;
+    }
+
+    template <typename Tail, typename Fold, typename T>
+    [[gnu::always_inline]] static uint32_t tail(T const* lb, T const* rb, size_t size) noexcept {
+        return tailErrors<Tail, Fold>(lb, rb, size);
+    }
+};
+
+struct VecSSE {
+    static constexpr size_t WIDTH = 16;
+    static constexpr size_t GROUP = 8 * WIDTH;
+    using Narrower = VecSWAR;
+    template <typename T>
+    static constexpr unsigned BITS = sizeof(T);
+
+    template <typename Fold, typename T>
+    [[gnu::always_inline]] static uint32_t errors(T const* lb, T const* rb) noexcept {
+        if constexpr (sizeof(T) == 1) {
+            return errors16<Fold>(lb, rb);
+        } else {
+            __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lb));
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rb));
+            __m128i equal = sizeof(T) == 2 ? _mm_cmpeq_epi16(chunk, target) : _mm_cmpeq_epi32(chunk, target);
+            return ~_mm_movemask_epi8(equal) & 0xffff;
+        }
+    }
+
+    template <typename Fold>
+    [[gnu::always_inline]] static bool equalGroup(it lb, it rb) noexcept {
+        __m128i equal = _mm_set1_epi8(-1);
+        for (size_t k = 0; k != GROUP; k += WIDTH) {
+            __m128i target = Fold::fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lb + k)));
+            __m128i chunk = Fold::fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rb + k)));
+            equal = _mm_and_si128(equal, _mm_cmpeq_epi8(chunk, target));
+        }
+        return _mm_movemask_epi8(equal) == 0xffff;
+    }
+
+    template <typename Tail, typename Fold, typename T>
+    [[gnu::always_inline]] static uint32_t tail(T const* lb, T const* rb, size_t size) noexcept {
+        return tailErrors<Tail, Fold>(lb, rb, size);
+    }
+};
+
+// The tails of VecAVX2 are 16-byte SSE2 compares, so only errors() is compiled for AVX2
+struct VecAVX2 {
+    static constexpr size_t WIDTH = 32;
+    static constexpr size_t GROUP = 4 * WIDTH;
+    using Narrower = VecSSE;
+    template <typename T>
+    static constexpr unsigned BITS = sizeof(T);
+
+    template <typename Fold, typename T>
+    static uint32_t errors(T const* lb, T const* rb) noexcept;
+
+    template <typename Fold>
+    static bool equalGroup(it lb, it rb) noexcept;
+
+    template <typename Tail, typename Fold, typename T>
+    [[gnu::always_inline]] static uint32_t tail(T const* lb, T const* rb, size_t size) noexcept {
+        return tailErrors<Tail, Fold>(lb, rb, size);
+    }
+};
+
+// Masked-out bytes are never read, so the tail needs no page check. Mask compares give one bit per element.
+struct VecAVX512 {
+    static constexpr size_t WIDTH = 64;
+    static constexpr size_t GROUP = 4 * WIDTH;
+    template <typename T>
+    static constexpr unsigned BITS = 1;
+
+    template <typename Fold, typename T>
+    static uint64_t errors(T const* lb, T const* rb) noexcept;
+
+    template <typename Fold>
+    static bool equalGroup(it lb, it rb) noexcept;
+
+    template <typename Tail, typename Fold, typename T>
+    static uint64_t tail(T const* lb, T const* rb, size_t size) noexcept;
+};
+
+ONECHANGE_TARGET_AVX2_BEGIN
+template <typename Fold, typename T>
+inline uint32_t VecAVX2::errors(T const* lb, T const* rb) noexcept {
+    __m256i target = Fold::fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lb)));
+    __m256i chunk = Fold::fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rb)));
+    if constexpr (sizeof(T) == 1) {
+        return ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target));
+    } else if constexpr (sizeof(T) == 2) {
+        return ~_mm256_movemask_epi8(_mm256_cmpeq_epi16(chunk, target));
+    } else {
+        return ~_mm256_movemask_epi8(_mm256_cmpeq_epi32(chunk, target));
+    }
+}
+
+template <typename Fold>
+inline bool VecAVX2::equalGroup(it lb, it rb) noexcept {
+    __m256i equal = _mm256_set1_epi8(-1);
+    for (size_t k = 0; k != GROUP; k += WIDTH) {
+        __m256i target = Fold::fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lb + k)));
+        __m256i chunk = Fold::fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rb + k)));
+        equal = _mm256_and_si256(equal, _mm256_cmpeq_epi8(chunk, target));
+    }
+    return _mm256_movemask_epi8(equal) == -1;
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+template <typename Fold, typename T>
+inline uint64_t VecAVX512::errors(T const* lb, T const* rb) noexcept {
+    __m512i target = Fold::fold(_mm512_loadu_si512(lb));
+    __m512i chunk = Fold::fold(_mm512_loadu_si512(rb));
+    if constexpr (sizeof(T) == 1) {
+        return _mm512_cmpneq_epi8_mask(chunk, target);
+    } else if constexpr (sizeof(T) == 2) {
+        return _mm512_cmpneq_epi16_mask(chunk, target);
+    } else {
+        return _mm512_cmpneq_epi32_mask(chunk, target);
+    }
+}
+
+template <typename Fold>
+inline bool VecAVX512::equalGroup(it lb, it rb) noexcept {
+    __m512i diff = _mm512_setzero_si512();
+    for (size_t k = 0; k != GROUP; k += WIDTH) {
+        __m512i target = Fold::fold(_mm512_loadu_si512(lb + k));
+        __m512i chunk = Fold::fold(_mm512_loadu_si512(rb + k));
+        diff = _mm512_or_si512(diff, _mm512_xor_si512(chunk, target));
+    }
+    return _mm512_test_epi64_mask(diff, diff) == 0;
+}
+
+template <typename Tail, typename Fold, typename T>
+inline uint64_t VecAVX512::tail(T const* lb, T const* rb, size_t size) noexcept {
+    const __mmask64 mask = _bzhi_u64(~0ull, size);
+    if constexpr (sizeof(T) == 1) {
+        __m512i target = Fold::fold(_mm512_maskz_loadu_epi8(mask, lb));
+        __m512i chunk = Fold::fold(_mm512_maskz_loadu_epi8(mask, rb));
+        return _mm512_mask_cmpneq_epi8_mask(mask, chunk, target);
+    } else if constexpr (sizeof(T) == 2) {
+        return _mm512_mask_cmpneq_epi16_mask(mask, _mm512_maskz_loadu_epi16(mask, rb), _mm512_maskz_loadu_epi16(mask, lb));
+    } else {
+        return _mm512_mask_cmpneq_epi32_mask(mask, _mm512_maskz_loadu_epi32(mask, rb), _mm512_maskz_loadu_epi32(mask, lb));
+    }
+}
+ONECHANGE_TARGET_END
+
+
+// Operation sets of the Fast kernels: which single edit is accepted. Each switched off edit drops its branch
+// from the kernel. A transposition swaps two adjacent bytes, its two errors are checked only after a second error.
+struct HammingEdits {
+    static constexpr bool REPLACE = true;
+    static constexpr bool INDEL = false;
+    static constexpr bool TRANSPOSE = false;
+};
+
+struct IndelEdits {
+    static constexpr bool REPLACE = false;
+    static constexpr bool INDEL = true;
+    static constexpr bool TRANSPOSE = false;
+};
+
+struct LevenshteinEdits {
+    static constexpr bool REPLACE = true;
+    static constexpr bool INDEL = true;
+    static constexpr bool TRANSPOSE = false;
+};
+
+struct DamerauEdits {
+    static constexpr bool REPLACE = true;
+    static constexpr bool INDEL = true;
+    static constexpr bool TRANSPOSE = true;
+};
+
+// Report policies of the Fast kernels: how the verdict is built. OneChangeBool compiles to the plain bool scan,
+// OneChangeLocate also keeps the offset of the edit (diff-size kernels see lhs as the longer one, so Delete there
+// means "lhs[offset] is extra", swapped() turns it into Insert when the arguments were swapped).
+struct OneChangeBool {
+    using result_type = bool;
+    static constexpr bool LOCATE = false;
+
+    static constexpr bool equal() noexcept { return true; }
+    static constexpr bool replace(size_t) noexcept { return true; }
+    static constexpr bool extra(size_t) noexcept { return true; }
+    static constexpr bool transpose(size_t) noexcept { return true; }
+    static constexpr bool none() noexcept { return false; }
+    static constexpr bool swapped(bool result) noexcept { return result; }
+};
+
+struct OneChangeLocate {
+    using result_type = OneChangeResult;
+    static constexpr bool LOCATE = true;
+
+    static constexpr OneChangeResult equal() noexcept { return {OneChangeKind::Equal, 0}; }
+    static constexpr OneChangeResult replace(size_t offset) noexcept { return {OneChangeKind::Replace, offset}; }
+    static constexpr OneChangeResult extra(size_t offset) noexcept { return {OneChangeKind::Delete, offset}; }
+    static constexpr OneChangeResult transpose(size_t offset) noexcept { return {OneChangeKind::Transpose, offset}; }
+    static constexpr OneChangeResult none() noexcept { return {OneChangeKind::None, 0}; }
+    static constexpr OneChangeResult swapped(OneChangeResult result) noexcept {
+        return result.kind == OneChangeKind::Delete ? OneChangeResult{OneChangeKind::Insert, result.offset} : result;
+    }
+};
+
+static constexpr size_t NO_ERROR = ~size_t{0};
+
+// Long-input mode of the block scans: from LONG_SIZE bytes on, equal bytes are skipped a group at a time with
+// one branch per GROUP bytes instead of a mask test per block. After one unaligned block the loads of lb are
+// WIDTH-aligned; inputs past the L2 size are also prefetched ahead.
+static constexpr size_t LONG_SIZE = 1024;
+static constexpr size_t LONG_PREFETCH_SIZE = 512 * 1024;
+static constexpr size_t LONG_PREFETCH_DISTANCE = 1024;
+
+// Skips equal bytes of [lb + i, lb + size) (size - i >= LONG_SIZE), returns where a group with an error starts
+// or the end of the whole groups. The caller's block loop locates the error from there.
+template <typename V, typename Fold>
+[[gnu::always_inline]] inline size_t equalPrefix(it lb, it rb, size_t i, size_t size) noexcept {
+    if (V::template errors<Fold>(lb + i, rb + i) != 0) {
+        return i;
+    }
+    i += V::WIDTH - reinterpret_cast<uintptr_t>(lb + i) % V::WIDTH;
+    const bool prefetch = size - i >= LONG_PREFETCH_SIZE;
+    for (; i + V::GROUP <= size; i += V::GROUP) {
+        if (prefetch) {
+            _mm_prefetch(lb + i + LONG_PREFETCH_DISTANCE, _MM_HINT_T0);
+            _mm_prefetch(rb + i + LONG_PREFETCH_DISTANCE, _MM_HINT_T0);
+        }
+        if (!V::template equalGroup<Fold>(lb + i, rb + i)) [[unlikely]] {
+            break;
+        }
+    }
+    return i;
+}
+
+template <typename V, typename Tail, typename Fold>
+[[gnu::always_inline]] inline bool sameBytes(it lb, it rb, size_t size) noexcept {
+    size_t i = 0;
+    for (; i + V::WIDTH <= size; i += V::WIDTH) {
+        if (V::template errors<Fold>(lb + i, rb + i) != 0) {
+            return false;
+        }
+    }
+    return V::template tail<Tail, Fold>(lb + i, rb + i, size - i) == 0;
+}
+
+// Same-size strings with the first error at `first` and another one after it: one transposition iff
+// lb[first, first + 1] is rb[first, first + 1] swapped and the rest of [first + 2, size) matches
+template <typename V, typename Report, typename Tail, typename Fold>
+[[gnu::always_inline]] inline typename Report::result_type secondError(it lb, it rb, size_t size,
+                                                                       size_t first) noexcept {
+    const auto next = first + 1;
+    if (next == size || Fold::fold(lb[first]) != Fold::fold(rb[next]) || Fold::fold(lb[next]) != Fold::fold(rb[first])) {
+        return Report::none();
+    }
+    return sameBytes<V, Tail, Fold>(lb + next + 1, rb + next + 1, size - next - 1) ? Report::transpose(first)
+                                                                                   : Report::none();
+}
+
+// [lb, lb + size) vs [rb, rb + size) after `offset` already compared bytes, errorAt is the known error or NO_ERROR
+template <typename V, typename Report, typename Tail, typename Fold, typename Ops>
+[[gnu::always_inline]] inline typename Report::result_type tailSameSize(it lb, it rb, size_t size, size_t offset,
+                                                                        size_t errorAt) noexcept {
+    ONECHANGE_COUNT_TAIL(size);
+    const auto errors = V::template tail<Tail, Fold>(lb, rb, size);
+    if (errorAt == NO_ERROR) {
+        if (errors == 0) {
+            ONECHANGE_COUNT(noMismatch);
+        } else {
+            ONECHANGE_COUNT_MISMATCH(offset + std::countr_zero(errors));
+        }
+    }
+    if (errors == 0) {
+        return errorAt == NO_ERROR ? Report::equal() : Report::replace(errorAt);
+    } else if (!Ops::REPLACE) {
+        return Report::none();
+    } else if (errorAt != NO_ERROR || (errors & (errors - 1)) != 0) {
+        if constexpr (Ops::TRANSPOSE) {
+            const auto first = errorAt != NO_ERROR ? errorAt : offset + std::countr_zero(errors);
+            return secondError<V, Report, Tail, Fold>(lb - offset, rb - offset, offset + size, first);
+        }
+        return Report::none();
+    }
+    return Report::replace(offset + std::countr_zero(errors));
+}
+
+// lhs is one symbol longer (size + 1 bytes) and there is no error before lb:
+// the first mismatch is the extra symbol, the rest must match shifted by one
+template <typename V, typename Report, typename Tail, typename Fold>
+[[gnu::always_inline]] inline typename Report::result_type tailDiffSize(it lb, it rb, size_t size,
+                                                                        size_t offset) noexcept {
+    ONECHANGE_COUNT_TAIL(size);
+    const auto direct = V::template tail<Tail, Fold>(lb, rb, size);
+    if (direct == 0) {
+        ONECHANGE_COUNT_MISMATCH(offset + size);
+        return Report::extra(offset + size);
+    }
+    const auto firstError = std::countr_zero(direct);
+    ONECHANGE_COUNT_MISMATCH(offset + firstError);
+    return (V::template tail<Tail, Fold>(lb + 1, rb, size) >> firstError) == 0 ? Report::extra(offset + firstError)
+                                                                               : Report::none();
+}
+
+
+// The kernels are default-target always_inline templates: inlined into the per-level entries below, V's
+// intrinsics end up in a function compiled for V's instruction set.
+template <typename V, typename Report, typename Tail, typename Fold, typename Ops = LevenshteinEdits>
+[[gnu::always_inline]] inline typename Report::result_type oneChangeSameSizeT(std::string_view lhs,
+                                                                              std::string_view rhs) noexcept {
+    assert(lhs.size() == rhs.size());
+    const auto size = lhs.size();
+    size_t errorAt = NO_ERROR;
+    ONECHANGE_COUNT_CALL(size);
+    ONECHANGE_COUNT(sameSize);
+
+    size_t i = 0;
+    if (size >= LONG_SIZE) {
+        i = equalPrefix<V, Fold>(lhs.data(), rhs.data(), i, size);
+    }
+    for (; i + V::WIDTH <= size; i += V::WIDTH) {
+        const auto errors = V::template errors<Fold>(lhs.data() + i, rhs.data() + i);
+
+        if (errors != 0) [[unlikely]] {
+            if (errorAt == NO_ERROR) {
+                ONECHANGE_COUNT_MISMATCH(i + std::countr_zero(errors));
+            }
+            if (!Ops::REPLACE) {
+                return Report::none();
+            } else if ((errors & (errors - 1)) != 0 || errorAt != NO_ERROR) {
+                if constexpr (Ops::TRANSPOSE) {
+                    const auto first = errorAt != NO_ERROR ? errorAt : i + std::countr_zero(errors);
+                    return secondError<V, Report, Tail, Fold>(lhs.data(), rhs.data(), size, first);
                 }
-                i -= !oneSizeLocal;
+                return Report::none();
+            }
+            errorAt = Report::LOCATE || Ops::TRANSPOSE ? i + std::countr_zero(errors) : i;
+            if (size - i >= LONG_SIZE + V::WIDTH) {
+                // the rest has to match, the loop goes on from the block where equalPrefix() stops
+                i = equalPrefix<V, Fold>(lhs.data(), rhs.data(), i + V::WIDTH, size) - V::WIDTH;
             }
         }
-        return true;
-    };
+    }
 
+    return tailSameSize<V, Report, Tail, Fold, Ops>(lhs.data() + i, rhs.data() + i, size - i, i, errorAt);
+}
 
-    for (size_t i = 0; i + 16 <= minSize; i += 16) {
-        __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + i + (oneError && !oneSize)));
-        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + i));
-        __m128i cmpResult = _mm_cmpeq_epi8(chunk, target);
-        auto count = countOfErrors(cmpResult);
+template <typename V, typename Report, typename Tail, typename Fold>
+[[gnu::always_inline]] inline typename Report::result_type oneChangeDiffSizeT(std::string_view lhs,
+                                                                              std::string_view rhs) noexcept {
+    assert(lhs.size() > rhs.size());
+    const auto minSize = rhs.size();
+    ONECHANGE_COUNT_CALL(minSize);
+    if (lhs.size() - minSize != 1) {
+        ONECHANGE_COUNT(lengthRejects);
+        return Report::none();
+    }
+    ONECHANGE_COUNT(diffSize);
 
-        if (count != 0) {
-            if (oneError || (oneSize && count > 1)) {
-                return false;
-            } else if (count == 1 && oneSize) {
-                oneError = true;
-            } else if (!slow(lhs.data() + i, lhs.data() + i + 16 + 1, rhs.data() + i, rhs.data() + i + 16)
-                        || (--i, false)) {
-                // count > 1 && different size
-                return false;
+    size_t i = 0;
+    if (minSize >= LONG_SIZE) {
+        i = equalPrefix<V, Fold>(lhs.data(), rhs.data(), i, minSize);
+    }
+    for (; i + V::WIDTH <= minSize; i += V::WIDTH) {
+        const auto errors = V::template errors<Fold>(lhs.data() + i, rhs.data() + i);
+
+        if (errors != 0) [[unlikely]] {
+            // the extra symbol is at the first error, the rest is compared shifted by one
+            i += std::countr_zero(errors);
+            const auto errorAt = i;
+            ONECHANGE_COUNT_MISMATCH(errorAt);
+            if (minSize - i >= LONG_SIZE) {
+                i = equalPrefix<V, Fold>(lhs.data() + 1, rhs.data(), i, minSize);
+            }
+            for (; i + V::WIDTH <= minSize; i += V::WIDTH) {
+                if (V::template errors<Fold>(lhs.data() + i + 1, rhs.data() + i) != 0) [[unlikely]] {
+                    return Report::none();
+                }
             }
+            ONECHANGE_COUNT_TAIL(minSize - i);
+            return V::template tail<Tail, Fold>(lhs.data() + i + 1, rhs.data() + i, minSize - i) == 0
+                    ? Report::extra(errorAt) : Report::none();
         }
     }
 
-    auto pos = minSize - (minSize % 16);
-    return slow(lhs.data() + pos + (oneError && !oneSize), lhs.end(), rhs.data() + pos, rhs.end());
+    return tailDiffSize<V, Report, Tail, Fold>(lhs.data() + i, rhs.data() + i, minSize - i, i);
 }
 
+template <typename V, typename Report, typename Tail, typename Fold, typename Ops = LevenshteinEdits>
+[[gnu::always_inline]] inline typename Report::result_type oneChangeFastT(std::string_view lhs,
+                                                                          std::string_view rhs) noexcept {
+    if (lhs.size() == rhs.size()) {
+        return oneChangeSameSizeT<V, Report, Tail, Fold, Ops>(lhs, rhs);
+    } else if (!Ops::INDEL) {
+        ONECHANGE_COUNT_CALL(std::min(lhs.size(), rhs.size()));
+        ONECHANGE_COUNT(lengthRejects);
+        return Report::none();
+    } else if (lhs.size() > rhs.size()) {
+        return oneChangeDiffSizeT<V, Report, Tail, Fold>(lhs, rhs);
+    }
+    return Report::swapped(oneChangeDiffSizeT<V, Report, Tail, Fold>(rhs, lhs));
+}
 
-bool oneChangeAVX(std::string_view lhs, std::string_view rhs) noexcept {
+// Wide kernel of oneChangeDetailWide(): the first i in [from, size) with lhs[i] != rhs[i] or size, over the same
+// blocks, tails and long-input mode as the byte kernels. An error of element i is bit i * BITS<T> of the mask.
+template <typename V, typename T>
+[[gnu::always_inline]] inline size_t firstMismatchT(T const* lhs, T const* rhs, size_t from, size_t size) noexcept {
+    constexpr size_t LANES = V::WIDTH / sizeof(T);
+    size_t i = from;
+    if ((size - from) * sizeof(T) >= LONG_SIZE) {
+        const auto lb = reinterpret_cast<it>(lhs);
+        const auto rb = reinterpret_cast<it>(rhs);
+        i = equalPrefix<V, ExactBytes>(lb, rb, i * sizeof(T), size * sizeof(T)) / sizeof(T);
+    }
+    for (; i + LANES <= size; i += LANES) {
+        if (const auto errors = V::template errors<ExactBytes>(lhs + i, rhs + i); errors != 0) [[unlikely]] {
+            return i + std::countr_zero(errors) / V::template BITS<T>;
+        }
+    }
+    const auto errors = V::template tail<PageSafeTail, ExactBytes>(lhs + i, rhs + i, size - i);
+    return errors != 0 ? i + std::countr_zero(errors) / V::template BITS<T> : size;
+}
+
+// lhs has minSize + extra elements
+template <typename V, typename T>
+[[gnu::always_inline]] inline OneChangeResult oneEditWideT(T const* lhs, T const* rhs, size_t minSize,
+                                                           bool extra) noexcept {
+    const auto first = firstMismatchT<V>(lhs, rhs, 0, minSize);
+    if (first == minSize) {
+        return extra ? OneChangeLocate::extra(minSize) : OneChangeLocate::equal();
+    } else if (firstMismatchT<V>(lhs + extra, rhs, first + !extra, minSize) != minSize) {
+        return OneChangeLocate::none();
+    }
+    return extra ? OneChangeLocate::extra(first) : OneChangeLocate::replace(first);
+}
+
+// Block scan of oneChange()/oneChangeAVX(): a block with errors of strings of different size is resolved
+// by the byte loop
+template <typename V>
+[[gnu::always_inline]] inline bool oneChangeCommonT(std::string_view lhs, std::string_view rhs) noexcept {
     if (lhs.size() < rhs.size()) {
-        return oneChange(rhs, lhs);
+        std::swap(lhs, rhs);
     }
 
     const auto maxSize = lhs.size();
     const auto minSize = rhs.size();
+    ONECHANGE_COUNT_CALL(minSize);
     if (maxSize - minSize > 1) {
+        ONECHANGE_COUNT(lengthRejects);
         return false;
     }
 
     const bool oneSize = maxSize == minSize;
     bool oneError = false;
+    if (oneSize) {
+        ONECHANGE_COUNT(sameSize);
+    } else {
+        ONECHANGE_COUNT(diffSize);
+    }
 
     const auto slow = [&oneError](it lb, it le, it rb, it re) noexcept {
         const size_t size = re - rb;
@@ -235,19 +826,17 @@ bool oneChangeAVX(std::string_view lhs, std::string_view rhs) noexcept {
         return true;
     };
 
-
-    for (size_t i = 0; i + 32 <= minSize; i += 32) {
-        __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i + (oneError && !oneSize)));
-        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + i));
-        __m256i cmpResult = _mm256_cmpeq_epi8(chunk, target);
-        auto count = countOfErrors(cmpResult);
+    for (size_t i = 0; i + V::WIDTH <= minSize; i += V::WIDTH) {
+        const auto count = std::popcount(V::template errors<ExactBytes>(lhs.data() + i + (oneError && !oneSize),
+                                                                         rhs.data() + i));
 
         if (count != 0) {
             if (oneError || (oneSize && count > 1)) {
                 return false;
             } else if (count == 1 && oneSize) {
                 oneError = true;
-            } else if (!slow(lhs.data() + i, lhs.data() + i + 32 + 1, rhs.data() + i, rhs.data() + i + 32)
+            } else if (ONECHANGE_COUNT(byteLoops),
+                       !slow(lhs.data() + i, lhs.data() + i + V::WIDTH + 1, rhs.data() + i, rhs.data() + i + V::WIDTH)
                        || (--i, false)) {
                 // count > 1 && different size
                 return false;
@@ -255,261 +844,474 @@ bool oneChangeAVX(std::string_view lhs, std::string_view rhs) noexcept {
         }
     }
 
-    auto pos = minSize - (minSize % 32);
+    auto pos = minSize - (minSize % V::WIDTH);
     return slow(lhs.data() + pos + (oneError && !oneSize), lhs.end(), rhs.data() + pos, rhs.end());
-};
+}
 
 
-bool slowF(it lb, it le, it rb, it re) noexcept {
-    const auto size = re - rb;
-    assert(le - lb == size + 1);
-    if (size == 0) {
-        return true;
+// Error mask of [lb, lb + S) vs [rb, rb + S) for a compile-time S <= 64: S / WIDTH blocks and an overlapping
+// last block, fully unrolled. Shorter strings use a narrower vector or, if there is none, the masked/SWAR tail.
+template <typename V, size_t S>
+[[gnu::always_inline]] inline uint64_t fixedErrors(it lb, it rb) noexcept {
+    static_assert(S <= 64);
+    constexpr size_t W = V::WIDTH;
+    if constexpr (S == 0) {
+        return 0;
+    } else if constexpr (S < W) {
+        if constexpr (requires { typename V::Narrower; }) {
+            return fixedErrors<typename V::Narrower, S>(lb, rb);
+        } else {
+            return V::template tail<PageSafeTail, ExactBytes>(lb, rb, S);
+        }
+    } else {
+        uint64_t errors = 0;
+#pragma GCC unroll 8
+        for (size_t i = 0; i + W <= S; i += W) {
+            errors |= uint64_t{V::template errors<ExactBytes>(lb + i, rb + i)} << i;
+        }
+        if constexpr (S % W != 0) {
+            errors |= uint64_t{V::template errors<ExactBytes>(lb + S - W, rb + S - W)} << (S - W);
+        }
+        return errors;
     }
-    int i = 0;
-    const auto fnDiffSizeOneError = [&]() {
-        for (; i != size; ++i) {
-            if (lb[i + 1] != rb[i]) {
-                return false;
-            }
+}
+
+// oneChangeFixed<N, M>(): the masks of the whole strings are built without branches, the verdict is one compare.
+// Different sizes: the extra byte of the longer string can be at p iff the strings match before p and match
+// shifted by one after it, i.e. the first straight error is not before the end of the shifted errors.
+template <typename V, size_t N, size_t M>
+[[gnu::always_inline]] inline bool oneChangeFixedT(it lhs, it rhs) noexcept {
+    ONECHANGE_COUNT_CALL(std::min(N, M));
+    ONECHANGE_COUNT(fixedKernels);
+    if constexpr (N == M) {
+        ONECHANGE_COUNT(sameSize);
+        const auto errors = fixedErrors<V, N>(lhs, rhs);
+        return (errors & (errors - 1)) == 0;
+    } else {
+        ONECHANGE_COUNT(diffSize);
+        constexpr size_t S = std::min(N, M);
+        const auto lb = N > M ? lhs : rhs;
+        const auto sb = N > M ? rhs : lhs;
+        const auto straight = fixedErrors<V, S>(lb, sb);
+        const auto shifted = fixedErrors<V, S>(lb + 1, sb);
+        return std::countr_zero(straight) >= static_cast<int>(std::bit_width(shifted));
+    }
+}
+
+// oneChangeFastT() where the sizes of oneChangeFixed() take the unrolled kernels
+template <typename V>
+[[gnu::always_inline]] inline bool oneChangeSizedT(std::string_view lhs, std::string_view rhs) noexcept {
+    if (lhs.size() == rhs.size()) {
+        switch (lhs.size()) {
+            case 16: return oneChangeFixedT<V, 16, 16>(lhs.data(), rhs.data());
+            case 32: return oneChangeFixedT<V, 32, 32>(lhs.data(), rhs.data());
+            case 64: return oneChangeFixedT<V, 64, 64>(lhs.data(), rhs.data());
         }
-        return true;
-    };
-    const auto fnDiffSizeNoError = [&]() {
-        for (; i != size; ++i) {
-            if (lb[i] != rb[i]) {
-                return fnDiffSizeOneError();
-            }
+        return oneChangeSameSizeT<V, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+    }
+
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() == rhs.size() + 1) {
+        switch (rhs.size()) {
+            case 15: return oneChangeFixedT<V, 16, 15>(lhs.data(), rhs.data());
+            case 16: return oneChangeFixedT<V, 17, 16>(lhs.data(), rhs.data());
+            case 31: return oneChangeFixedT<V, 32, 31>(lhs.data(), rhs.data());
+            case 32: return oneChangeFixedT<V, 33, 32>(lhs.data(), rhs.data());
+            case 63: return oneChangeFixedT<V, 64, 63>(lhs.data(), rhs.data());
+            case 64: return oneChangeFixedT<V, 65, 64>(lhs.data(), rhs.data());
         }
-        return true;
-    };
+    }
+    return oneChangeDiffSizeT<V, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
 
-    return fnDiffSizeNoError();
+// Per-level entries of the kernels
+template <typename Report, typename Tail = PageSafeTail, typename Fold = ExactBytes, typename Ops = LevenshteinEdits>
+typename Report::result_type oneChangeSWART(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeFastT<VecSWAR, Report, Tail, Fold, Ops>(lhs, rhs);
 }
 
-__m128i load16(char const*const begin, size_t size) noexcept {
-    static constexpr auto STEP_SIZE = 16;
-    assert(size <= STEP_SIZE);
-    char buffer[STEP_SIZE];
-    memset(buffer, 0, STEP_SIZE);
-    memcpy(buffer, begin, size);
-    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+ONECHANGE_TARGET_SSE_BEGIN
+template <typename Report, typename Tail = PageSafeTail, typename Fold = ExactBytes, typename Ops = LevenshteinEdits>
+typename Report::result_type oneChangeSSET(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeFastT<VecSSE, Report, Tail, Fold, Ops>(lhs, rhs);
 }
+ONECHANGE_TARGET_END
 
-__m256i load32(char const*const begin, size_t size) noexcept {
-    static constexpr auto STEP_SIZE = 32;
-    assert(size <= STEP_SIZE);
-    alignas(STEP_SIZE) char buffer[STEP_SIZE];
-    memset(buffer, 0, STEP_SIZE);
-    memcpy(buffer, begin, size);
-    return _mm256_load_si256(reinterpret_cast<const __m256i*>(buffer));
+ONECHANGE_TARGET_AVX2_BEGIN
+template <typename Report, typename Tail = PageSafeTail, typename Fold = ExactBytes, typename Ops = LevenshteinEdits>
+typename Report::result_type oneChangeAVX2T(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeFastT<VecAVX2, Report, Tail, Fold, Ops>(lhs, rhs);
 }
+ONECHANGE_TARGET_END
 
+ONECHANGE_TARGET_AVX512_BEGIN
+template <typename Report, typename Tail = PageSafeTail, typename Fold = ExactBytes, typename Ops = LevenshteinEdits>
+typename Report::result_type oneChangeAVX512T(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeFastT<VecAVX512, Report, Tail, Fold, Ops>(lhs, rhs);
+}
+ONECHANGE_TARGET_END
 
-unsigned tailEqSIMD(it lb, it rb, size_t size) noexcept {
-    if (size == 0) {
-        return 0;
-    }
+template <size_t N, size_t M>
+bool oneChangeFixedSWAR(it lhs, it rhs) noexcept {
+    return oneChangeFixedT<VecSWAR, N, M>(lhs, rhs);
+}
 
-    const auto handle16 = [&]() {
-        auto lhs = load16(lb, size);
-        auto rhs = load16(rb, size);
-        auto cmp = _mm_cmpeq_epi8(lhs, rhs);
-        return countOfErrors(cmp);
-    };
+static bool oneChangeSizedSWAR(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSizedT<VecSWAR>(lhs, rhs);
+}
 
-    const auto handle32 = [&]() {
-        auto lhs = load32(lb, size);
-        auto rhs = load32(rb, size);
-        auto cmp = _mm256_cmpeq_epi8(lhs, rhs);
-        return countOfErrors(cmp);
-    };
+ONECHANGE_TARGET_SSE_BEGIN
+template <size_t N, size_t M>
+bool oneChangeFixedSSE(it lhs, it rhs) noexcept {
+    return oneChangeFixedT<VecSSE, N, M>(lhs, rhs);
+}
 
-    if (size <= 16) {
-        return handle16();
-    } else {
-        return handle32();
-    }
+static bool oneChangeSizedSSE(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSizedT<VecSSE>(lhs, rhs);
 }
+ONECHANGE_TARGET_END
 
+ONECHANGE_TARGET_AVX2_BEGIN
+template <size_t N, size_t M>
+bool oneChangeFixedAVX2(it lhs, it rhs) noexcept {
+    return oneChangeFixedT<VecAVX2, N, M>(lhs, rhs);
+}
 
-unsigned tailEqMEMCMP(it lb, it rb, size_t size) noexcept {
-    unsigned diff = 0;
-    for (const auto end = lb + size; lb != end; ++lb, ++rb) {
-        if (*lb != *rb) {
-            ++diff;
-        }
-    }
-    return diff;
+static bool oneChangeSizedAVX2(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSizedT<VecAVX2>(lhs, rhs);
 }
+ONECHANGE_TARGET_END
 
-bool oneChangeSameSizeFast(std::string_view lhs, std::string_view rhs) noexcept {
-    assert(lhs.size() == rhs.size());
-    const auto size = lhs.size();
-    if (size <= 16) {
-        return tailEqMEMCMP(lhs.data(), rhs.data(), size) <= 1;
-    }
-    bool oneError = false;
+ONECHANGE_TARGET_AVX512_BEGIN
+template <size_t N, size_t M>
+bool oneChangeFixedAVX512(it lhs, it rhs) noexcept {
+    return oneChangeFixedT<VecAVX512, N, M>(lhs, rhs);
+}
 
-    size_t i = 0;
-    const auto reducedSize = size - 16;
-    for (; i <= reducedSize; i += 16) {
-        __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + i));
-        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + i));
-        __m128i cmpResult = _mm_cmpeq_epi8(chunk, target);
-        auto count = countOfErrors(cmpResult);
-
-        if (count != 0) [[unlikely]] {
-            if (count > 1 || std::exchange(oneError, true)) {
-                return false;
-            }
-        }
+static bool oneChangeSizedAVX512(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSizedT<VecAVX512>(lhs, rhs);
+}
+ONECHANGE_TARGET_END
+
+template <typename Report, typename Tail = PageSafeTail, typename Fold = ExactBytes, typename Ops = LevenshteinEdits>
+typename Report::result_type oneChangeAtLevel(SimdLevel level, std::string_view lhs, std::string_view rhs) noexcept {
+    switch (level) {
+        case SimdLevel::Scalar: return oneChangeSWART<Report, Tail, Fold, Ops>(lhs, rhs);
+        case SimdLevel::SSE: return oneChangeSSET<Report, Tail, Fold, Ops>(lhs, rhs);
+        case SimdLevel::AVX2: return oneChangeAVX2T<Report, Tail, Fold, Ops>(lhs, rhs);
+        case SimdLevel::AVX512: return oneChangeAVX512T<Report, Tail, Fold, Ops>(lhs, rhs);
     }
+    return oneChangeSWART<Report, Tail, Fold, Ops>(lhs, rhs);
+}
 
-    return tailEqMEMCMP(lhs.data() + i, rhs.data() + i, size - i) + oneError <= 1;
+template <typename T>
+OneChangeResult oneEditWideSWAR(T const* lhs, T const* rhs, size_t minSize, bool extra) noexcept {
+    return oneEditWideT<VecSWAR>(lhs, rhs, minSize, extra);
 }
 
+ONECHANGE_TARGET_SSE_BEGIN
+template <typename T>
+OneChangeResult oneEditWideSSE(T const* lhs, T const* rhs, size_t minSize, bool extra) noexcept {
+    return oneEditWideT<VecSSE>(lhs, rhs, minSize, extra);
+}
+ONECHANGE_TARGET_END
 
-bool oneChangeDiffSizeFast(std::string_view lhs, std::string_view rhs) noexcept {
-    assert(lhs.size() > rhs.size());
-    const auto minSize = rhs.size();
-    if (lhs.size() - minSize != 1) {
-        return false;
-    }
+ONECHANGE_TARGET_AVX2_BEGIN
+template <typename T>
+OneChangeResult oneEditWideAVX2(T const* lhs, T const* rhs, size_t minSize, bool extra) noexcept {
+    return oneEditWideT<VecAVX2>(lhs, rhs, minSize, extra);
+}
+ONECHANGE_TARGET_END
 
-    if (minSize <= 16) {
-        return slowF(lhs.data(), lhs.end(), rhs.data(), rhs.end());
+ONECHANGE_TARGET_AVX512_BEGIN
+template <typename T>
+OneChangeResult oneEditWideAVX512(T const* lhs, T const* rhs, size_t minSize, bool extra) noexcept {
+    return oneEditWideT<VecAVX512>(lhs, rhs, minSize, extra);
+}
+ONECHANGE_TARGET_END
+
+template <typename T>
+OneChangeResult oneEditWideAtLevel(SimdLevel level, T const* lhs, T const* rhs, size_t minSize,
+                                   bool extra) noexcept {
+    switch (level) {
+        case SimdLevel::Scalar: return oneEditWideSWAR(lhs, rhs, minSize, extra);
+        case SimdLevel::SSE: return oneEditWideSSE(lhs, rhs, minSize, extra);
+        case SimdLevel::AVX2: return oneEditWideAVX2(lhs, rhs, minSize, extra);
+        case SimdLevel::AVX512: return oneEditWideAVX512(lhs, rhs, minSize, extra);
     }
+    return oneEditWideSWAR(lhs, rhs, minSize, extra);
+}
 
-    size_t i = 0;
-    const auto reducedSize = minSize - 16;
-    const auto fnOneError = [&]() {
-        for (; i <= reducedSize; i += 16) {
-            __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + i + 1));
-            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + i));
-            __m128i cmpResult = _mm_cmpeq_epi8(chunk, target);
-            int mask = _mm_movemask_epi8(cmpResult);
-
-            if (mask != 0x0000ffff) [[unlikely]] {
-                return false;
-            }
-        }
-        return tailEqMEMCMP(lhs.data() + i + 1, rhs.data() + i, minSize - i) == 0;
-    };
+OneChangeResult oneEditWide(SimdLevel level, uint16_t const* lhs, uint16_t const* rhs, size_t minSize,
+                            bool extra) noexcept {
+    return oneEditWideAtLevel(level, lhs, rhs, minSize, extra);
+}
 
-    const auto fnNoError = [&]() {
-        for (; i <= reducedSize; i += 16) {
-            __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs.data() + i));
-            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs.data() + i));
-            __m128i cmpResult = _mm_cmpeq_epi8(chunk, target);
-            int mask = _mm_movemask_epi8(cmpResult);
-
-            if (mask != 0x0000ffff) [[unlikely]] {
-                auto firstError = findFirstError(mask);
-                i += firstError;
-                return fnOneError();
-            }
+OneChangeResult oneEditWide(SimdLevel level, uint32_t const* lhs, uint32_t const* rhs, size_t minSize,
+                            bool extra) noexcept {
+    return oneEditWideAtLevel(level, lhs, rhs, minSize, extra);
+}
 
-        }
 
-        return slowF(lhs.data() + i, lhs.end(), rhs.data() + i, rhs.end());
-    };
+bool oneChangeSameSizeFastSWAR(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSameSizeT<VecSWAR, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizeFastSWAR(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecSWAR, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeSameSizePaddedSWAR(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSameSizeT<VecSWAR, OneChangeBool, PaddedTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizePaddedSWAR(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecSWAR, OneChangeBool, PaddedTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeFastSWAR(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSWART<OneChangeBool>(lhs, rhs);
+}
+
+ONECHANGE_TARGET_SSE_BEGIN
+bool oneChangeSameSizeFast(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSameSizeT<VecSSE, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizeFast(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecSSE, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
 
-    return fnNoError();
+bool oneChangeSameSizePadded(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSameSizeT<VecSSE, OneChangeBool, PaddedTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizePadded(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecSSE, OneChangeBool, PaddedTail, ExactBytes>(lhs, rhs);
 }
 
 bool oneChangeFast(std::string_view lhs, std::string_view rhs) noexcept {
-    if (lhs.size() == rhs.size()) {
-        return oneChangeSameSizeFast(lhs, rhs);
-    } else if (lhs.size() < rhs.size()) {
-        return oneChangeDiffSizeFast(rhs, lhs);
-    } else {
-        return oneChangeDiffSizeFast(lhs, rhs);
-    }
+    return oneChangeSSET<OneChangeBool>(lhs, rhs);
 }
 
+bool oneChange(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeCommonT<VecSSE>(lhs, rhs);
+}
+ONECHANGE_TARGET_END
 
+ONECHANGE_TARGET_AVX2_BEGIN
 bool oneChangeSameSizeFastAVX(std::string_view lhs, std::string_view rhs) noexcept {
-    assert(lhs.size() == rhs.size());
-    bool oneError = false;
-    const auto size = lhs.size();
+    return oneChangeSameSizeT<VecAVX2, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizeFastAVX(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecAVX2, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeSameSizePaddedAVX(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSameSizeT<VecAVX2, OneChangeBool, PaddedTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizePaddedAVX(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecAVX2, OneChangeBool, PaddedTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeFastAVX(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAVX2T<OneChangeBool>(lhs, rhs);
+}
+
+bool oneChangeAVX(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeCommonT<VecAVX2>(lhs, rhs);
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+bool oneChangeSameSizeFastAVX512(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeSameSizeT<VecAVX512, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeDiffSizeFastAVX512(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeDiffSizeT<VecAVX512, OneChangeBool, PageSafeTail, ExactBytes>(lhs, rhs);
+}
+
+bool oneChangeFastAVX512(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAVX512T<OneChangeBool>(lhs, rhs);
+}
+ONECHANGE_TARGET_END
+
+
+bool oneChangePadded(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAtLevel<OneChangeBool, PaddedTail>(oneChangeAutoLevel(), lhs, rhs);
+}
+
+template <typename Fold>
+bool oneChangeFolded(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAtLevel<OneChangeBool, PageSafeTail, Fold>(oneChangeAutoLevel(), lhs, rhs);
+}
+
+// A new folding is a policy struct next to AsciiCaseFold plus its instantiation here
+template bool oneChangeFolded<AsciiCaseFold>(std::string_view, std::string_view) noexcept;
+template bool oneChangeFolded<DashUnderscoreFold>(std::string_view, std::string_view) noexcept;
+template bool oneChangeFolded<FoldAll<AsciiCaseFold, DashUnderscoreFold>>(std::string_view,
+                                                                          std::string_view) noexcept;
+
+template <typename Ops>
+bool oneChangeOps(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAtLevel<OneChangeBool, PageSafeTail, ExactBytes, Ops>(oneChangeAutoLevel(), lhs, rhs);
+}
+
+template bool oneChangeOps<HammingEdits>(std::string_view, std::string_view) noexcept;
+template bool oneChangeOps<IndelEdits>(std::string_view, std::string_view) noexcept;
+template bool oneChangeOps<LevenshteinEdits>(std::string_view, std::string_view) noexcept;
+template bool oneChangeOps<DamerauEdits>(std::string_view, std::string_view) noexcept;
+
+bool oneChangeOrTranspose(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeOps<DamerauEdits>(lhs, rhs);
+}
+
+OneChangeResult oneChangeDetailOrTranspose(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAtLevel<OneChangeLocate, PageSafeTail, ExactBytes, DamerauEdits>(oneChangeAutoLevel(), lhs, rhs);
+}
+
+template <size_t N, size_t M>
+bool oneChangeFixedKernel(char const* lhs, char const* rhs) noexcept {
+    static constexpr bool (*KERNELS[])(it, it) noexcept = {
+            oneChangeFixedSWAR<N, M>, oneChangeFixedSSE<N, M>, oneChangeFixedAVX2<N, M>, oneChangeFixedAVX512<N, M>
+    };
+    return KERNELS[static_cast<unsigned>(oneChangeAutoLevel())](lhs, rhs);
+}
 
-    if (size <= 32) {
-        return tailEqMEMCMP(lhs.data(), rhs.data(), size) <= 1;
+// The sizes of ONECHANGE_FIXED, oneChangeSizedT() switches over the same list
+template bool oneChangeFixedKernel<16, 15>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<16, 16>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<16, 17>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<32, 31>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<32, 32>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<32, 33>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<64, 63>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<64, 64>(char const*, char const*) noexcept;
+template bool oneChangeFixedKernel<64, 65>(char const*, char const*) noexcept;
+
+OneChangeResult oneChangeDetailSlow(std::string_view lhs, std::string_view rhs) noexcept {
+    const bool swapped = lhs.size() < rhs.size();
+    if (swapped) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() - rhs.size() > 1) {
+        return OneChangeLocate::none();
     }
 
-    size_t i = 0;
-    const auto reducedSize = size - 32;
-    for (; i <= reducedSize; i += 32) {
-        __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i));
-        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + i));
-        __m256i cmpResult = _mm256_cmpeq_epi8(chunk, target);
-        auto count = countOfErrors(cmpResult);
-
-        if (count != 0) [[unlikely]] {
-            if (count > 1 || std::exchange(oneError, true)) {
-                return false;
-            }
+    const size_t firstError = std::mismatch(rhs.begin(), rhs.end(), lhs.begin()).first - rhs.begin();
+    if (lhs.size() == rhs.size()) {
+        if (firstError == lhs.size()) {
+            return OneChangeLocate::equal();
         }
+        return lhs.substr(firstError + 1) == rhs.substr(firstError + 1)
+                ? OneChangeLocate::replace(firstError) : OneChangeLocate::none();
     }
 
-    return tailEqMEMCMP(lhs.data() + i, rhs.data() + i, size - i) + oneError <= 1;
+    if (lhs.substr(firstError + 1) != rhs.substr(firstError)) {
+        return OneChangeLocate::none();
+    }
+    return {swapped ? OneChangeKind::Insert : OneChangeKind::Delete, firstError};
 }
 
+OneChangeResult oneChangeDetail(std::string_view lhs, std::string_view rhs) noexcept {
+    return oneChangeAtLevel<OneChangeLocate>(oneChangeAutoLevel(), lhs, rhs);
+}
 
-bool oneChangeDiffSizeFastAVX(std::string_view lhs, std::string_view rhs) noexcept {
-    assert(lhs.size() > rhs.size());
-    const auto minSize = rhs.size();
-    if (lhs.size() - minSize != 1) {
-        return false;
-    }
 
-    if (minSize <= 32) {
-        return slowF(lhs.data(), lhs.end(), rhs.data(), rhs.end());
-    }
+static unsigned long long readXCR0() noexcept {
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
 
-    size_t i = 0;
-    const auto reducedSize = minSize - 32;
-    const auto fnOneError = [&]() {
-        for (; i <= reducedSize; i += 32) {
-            __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i + 1));
-            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + i));
-            __m256i cmpResult = _mm256_cmpeq_epi8(chunk, target);
-            unsigned int mask = _mm256_movemask_epi8(cmpResult);
-
-            if (mask != 0xffffffff) [[unlikely]] {
-                return false;
-            }
+SimdLevel detectSimdLevel() noexcept {
+    static const SimdLevel detected = []() noexcept {
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return SimdLevel::Scalar;
         }
-        return tailEqMEMCMP(lhs.data() + i + 1, rhs.data() + i, minSize - i) == 0;
-    };
 
-    const auto fnNoError = [&]() {
-        for (; i <= reducedSize; i += 32) {
-            __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i));
-            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + i));
-            __m256i cmpResult = _mm256_cmpeq_epi8(chunk, target);
-            unsigned int mask = _mm256_movemask_epi8(cmpResult);
-
-            if (mask != 0xffffffff) [[unlikely]] {
-                auto firstError = findFirstError(mask);
-                i += firstError;
-                return fnOneError();
-            }
+        const bool sse = (ecx & bit_SSSE3) && (ecx & bit_SSE4_1) && (ecx & bit_SSE4_2) && (ecx & bit_POPCNT);
+        if (!sse) {
+            return SimdLevel::Scalar;
         }
 
-        return slowF(lhs.data() + i, lhs.end(), rhs.data() + i, rhs.end());
-    };
+        // AVX state must be enabled by the OS, otherwise ymm/zmm registers fault even if cpuid reports them
+        if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+            return SimdLevel::SSE;
+        }
+        const auto xcr0 = readXCR0();
+        constexpr unsigned long long YMM_STATE = 0x6; // SSE + AVX
+        constexpr unsigned long long ZMM_STATE = 0xe0; // opmask + ZMM_Hi256 + Hi16_ZMM
+        if ((xcr0 & YMM_STATE) != YMM_STATE || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            return SimdLevel::SSE;
+        }
+
+        if (!(ebx & bit_AVX2) || !(ebx & bit_BMI) || !(ebx & bit_BMI2)) {
+            return SimdLevel::SSE;
+        }
 
-    return fnNoError();
+        const bool avx512 = (ebx & bit_AVX512F) && (ebx & bit_AVX512BW) && (ebx & bit_AVX512VL)
+                && (xcr0 & ZMM_STATE) == ZMM_STATE;
+        return avx512 ? SimdLevel::AVX512 : SimdLevel::AVX2;
+    }();
+
+    return detected;
 }
 
-bool oneChangeFastAVX(std::string_view lhs, std::string_view rhs) noexcept {
-    if (lhs.size() == rhs.size()) {
-        return oneChangeSameSizeFastAVX(lhs, rhs);
-    } else if (lhs.size() < rhs.size()) {
-        return oneChangeDiffSizeFastAVX(rhs, lhs);
-    } else {
-        return oneChangeDiffSizeFastAVX(lhs, rhs);
+std::string_view toString(SimdLevel level) noexcept {
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::SSE: return "sse";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
     }
+    return "unknown";
+}
+
+static bool resolveOneChangeAuto(std::string_view lhs, std::string_view rhs) noexcept;
+
+// Indexed by SimdLevel, the extra last slot binds the level on the first call.
+// The Fast kernels of the levels, keys of the oneChangeFixed() sizes take the unrolled kernels.
+static constexpr OneChangeFn AUTO_KERNELS[] = {
+        oneChangeSizedSWAR, oneChangeSizedSSE, oneChangeSizedAVX2, oneChangeSizedAVX512, resolveOneChangeAuto
+};
+static constexpr unsigned UNRESOLVED = std::size(AUTO_KERNELS) - 1;
+static std::atomic<unsigned> g_oneChangeLevel{UNRESOLVED};
+
+void setOneChangeAutoLevel(SimdLevel level) noexcept {
+    level = std::min(level, detectSimdLevel());
+    g_oneChangeLevel.store(static_cast<unsigned>(level), std::memory_order_relaxed);
+}
+
+SimdLevel oneChangeAutoLevel() noexcept {
+    if (g_oneChangeLevel.load(std::memory_order_relaxed) == UNRESOLVED) {
+        resolveOneChangeAuto({}, {});
+    }
+    return static_cast<SimdLevel>(g_oneChangeLevel.load(std::memory_order_relaxed));
+}
+
+static bool resolveOneChangeAuto(std::string_view lhs, std::string_view rhs) noexcept {
+    auto level = detectSimdLevel();
+    if (const char* forced = std::getenv("ONECHANGE_SIMD")) {
+        for (auto candidate : {SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (toString(candidate) == forced) {
+                level = std::min(candidate, level);
+            }
+        }
+    }
+
+    // an explicit setOneChangeAutoLevel() from another thread wins
+    auto expected = UNRESOLVED;
+    g_oneChangeLevel.compare_exchange_strong(expected, static_cast<unsigned>(level), std::memory_order_relaxed);
+    return oneChangeAuto(lhs, rhs);
+}
+
+bool oneChangeAuto(std::string_view lhs, std::string_view rhs) noexcept {
+    return AUTO_KERNELS[g_oneChangeLevel.load(std::memory_order_relaxed)](lhs, rhs);
 }
@@ -1,15 +1,224 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <immintrin.h>
 
 
+enum class SimdLevel : unsigned {
+    Scalar,
+    SSE,    // SSE4.2 + POPCNT
+    AVX2,   // AVX2 + BMI1/2
+    AVX512, // AVX-512 F/BW/VL
+};
+
+using OneChangeFn = bool(*)(std::string_view, std::string_view) noexcept;
+
+// How to get rhs from lhs
+enum class OneChangeKind : unsigned char {
+    Equal,
+    Replace,   // lhs[offset] != rhs[offset]
+    Insert,    // rhs[offset] is inserted before lhs[offset]
+    Delete,    // lhs[offset] is deleted
+    Transpose, // lhs[offset] and lhs[offset + 1] are swapped, only from oneChangeDetailOrTranspose()
+    None,      // more than one change
+};
+
+// offset of the first mismatching byte, 0 for Equal and None; within a run of equal bytes this is the last
+// position the edit could take ("aab" -> "ab" is Delete at 1, not 0)
+struct OneChangeResult {
+    OneChangeKind kind;
+    size_t offset;
+
+    bool operator==(OneChangeResult const&) const noexcept = default;
+};
+
 bool oneChangeSlow(std::string_view lhs, std::string_view rhs) noexcept;
 bool oneChangeNoSIMDFast(std::string_view lhs, std::string_view rhs) noexcept;
 bool oneChange(std::string_view lhs, std::string_view rhs) noexcept;
 bool oneChangeFast(std::string_view lhs, std::string_view rhs) noexcept;
 bool oneChangeAVX(std::string_view lhs, std::string_view rhs) noexcept;
 bool oneChangeFastAVX(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeFastAVX512(std::string_view lhs, std::string_view rhs) noexcept;
+// The Fast kernel on 8-byte words (SWAR) for CPUs without SSE4.2
+bool oneChangeFastSWAR(std::string_view lhs, std::string_view rhs) noexcept;
+
+// The Fast kernel of every vector width, one per SimdLevel: the matrix of tests and benchmarks
+struct OneChangeKernel {
+    SimdLevel level;
+    std::string_view name;
+    OneChangeFn fn;
+};
+
+inline constexpr OneChangeKernel FAST_KERNELS[] = {
+        {SimdLevel::Scalar, "swarFast", oneChangeFastSWAR},
+        {SimdLevel::SSE, "sseFast", oneChangeFast},
+        {SimdLevel::AVX2, "avxFast", oneChangeFastAVX},
+        {SimdLevel::AVX512, "avx512Fast", oneChangeFastAVX512},
+};
+
+// Same scan as the Fast kernels with the edit kind and position, see OneChangeLocate in fn.cpp
+OneChangeResult oneChangeDetail(std::string_view lhs, std::string_view rhs) noexcept;
+OneChangeResult oneChangeDetailSlow(std::string_view lhs, std::string_view rhs) noexcept;
+
+// Best kernel supported by the running CPU: the level is picked on the first call
+// (ONECHANGE_SIMD=scalar|sse|avx2|avx512 env variable can lower it) and can be changed later
+bool oneChangeAuto(std::string_view lhs, std::string_view rhs) noexcept;
+SimdLevel detectSimdLevel() noexcept;
+SimdLevel oneChangeAutoLevel() noexcept;
+// Force a lower tier (e.g. for A/B benchmarks), levels above detectSimdLevel() are clamped
+void setOneChangeAutoLevel(SimdLevel level) noexcept;
+std::string_view toString(SimdLevel level) noexcept;
+
+// The caller guarantees ONECHANGE_PADDING readable bytes after both strings (e.g. an arena with slack at the end),
+// so tails are loaded without page-edge checks. The AVX-512 level uses masked loads and needs no padding.
+inline constexpr size_t ONECHANGE_PADDING = 16;
+bool oneChangePadded(std::string_view lhs, std::string_view rhs) noexcept;
+
+// oneChange() with a byte equivalence: bytes a and b are equal if Fold maps them to the same byte. The folding
+// runs in the vector registers of the Fast kernels, nothing is allocated. Instantiated (see fn.cpp) for
+// AsciiCaseFold ('A' == 'a'), DashUnderscoreFold ('-' == '_') and FoldAll<AsciiCaseFold, DashUnderscoreFold>.
+struct AsciiCaseFold;
+struct DashUnderscoreFold;
+template <typename... Folds> struct FoldAll;
+template <typename Fold>
+bool oneChangeFolded(std::string_view lhs, std::string_view rhs) noexcept;
+
+// Keys of a compile-time length: lhs has N bytes, rhs has M = N - 1, N or N + 1. For N in ONECHANGE_FIXED a runtime
+// call is a fully unrolled kernel of the oneChangeAuto() level (no loops, the only branch is the verdict) and
+// oneChangeAuto() takes the same kernels for keys of these sizes. Other N call oneChangeAuto(). Constant evaluation
+// (compile-time tables) runs the byte loop of oneChangeFixedBytes().
+template <size_t N>
+inline constexpr bool ONECHANGE_FIXED = N == 16 || N == 32 || N == 64;
+
+template <size_t N, size_t M>
+bool oneChangeFixedKernel(char const* lhs, char const* rhs) noexcept;
+
+template <size_t N, size_t M>
+constexpr bool oneChangeFixedBytes(char const* lhs, char const* rhs) noexcept {
+    if constexpr (N == M) {
+        size_t errors = 0;
+        for (size_t i = 0; i != N; ++i) {
+            errors += lhs[i] != rhs[i];
+        }
+        return errors <= 1;
+    } else {
+        // the shorter one is rhs, its prefix and the rest shifted by one cover all of it
+        if constexpr (N < M) {
+            std::swap(lhs, rhs);
+        }
+        constexpr size_t size = N < M ? N : M;
+        size_t prefix = 0;
+        while (prefix != size && lhs[prefix] == rhs[prefix]) {
+            ++prefix;
+        }
+        size_t suffix = 0;
+        while (suffix != size && lhs[size - suffix] == rhs[size - 1 - suffix]) {
+            ++suffix;
+        }
+        return prefix + suffix >= size;
+    }
+}
+
+template <size_t N, size_t M = N>
+constexpr bool oneChangeFixed(char const* lhs, char const* rhs) noexcept {
+    static_assert(M + 1 >= N && M <= N + 1, "the sizes differ by more than one");
+    if (std::is_constant_evaluated()) {
+        return oneChangeFixedBytes<N, M>(lhs, rhs);
+    } else if constexpr (ONECHANGE_FIXED<N>) {
+        return oneChangeFixedKernel<N, M>(lhs, rhs);
+    } else {
+        return oneChangeAuto({lhs, N}, {rhs, M});
+    }
+}
+
+// Which single edit oneChangeOps() accepts: HammingEdits (replace), IndelEdits (insert or delete),
+// LevenshteinEdits (any of them, as oneChange()) or DamerauEdits (also a swap of two adjacent bytes, "teh" vs "the").
+// The kernel of a restricted set has no branches of the edits it doesn't accept.
+struct HammingEdits;
+struct IndelEdits;
+struct LevenshteinEdits;
+struct DamerauEdits;
+template <typename Ops>
+bool oneChangeOps(std::string_view lhs, std::string_view rhs) noexcept;
+// oneChangeOps<DamerauEdits>(), the scan of matching bytes is the one of oneChangeAuto()
+bool oneChangeOrTranspose(std::string_view lhs, std::string_view rhs) noexcept;
+OneChangeResult oneChangeDetailOrTranspose(std::string_view lhs, std::string_view rhs) noexcept;
+
+// Length of the longest common prefix/suffix, SIMD level follows oneChangeAuto()
+size_t commonPrefix(std::string_view lhs, std::string_view rhs) noexcept;
+size_t commonSuffix(std::string_view lhs, std::string_view rhs) noexcept;
+// One change iff commonPrefix + commonSuffix >= min size - (sizes are equal), the suffix is scanned only up to
+// where the prefix ended. The Parallel version scans the two ends at once, the suffix on a helper thread,
+// for strings from 64 KiB; shorter strings or a concurrent call take the single-thread path.
+bool oneChangeTwoEnded(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeTwoEndedParallel(std::string_view lhs, std::string_view rhs) noexcept;
+
+// UTF-8 strings differ by one replaced, inserted or deleted code point (of any byte length).
+// Expects valid UTF-8, malformed input is compared without a guarantee
+bool oneChangeUtf8(std::string_view lhs, std::string_view rhs) noexcept;
+
+// oneChange()/oneChangeDetail() over 16/32-bit elements: UTF-16 code units, UTF-32 code points or token ids.
+// Elements are compared whole, offsets are element indices.
+bool oneChangeWide(std::span<const uint16_t> lhs, std::span<const uint16_t> rhs) noexcept;
+bool oneChangeWide(std::span<const uint32_t> lhs, std::span<const uint32_t> rhs) noexcept;
+bool oneChangeWide(std::u16string_view lhs, std::u16string_view rhs) noexcept;
+bool oneChangeWide(std::u32string_view lhs, std::u32string_view rhs) noexcept;
+OneChangeResult oneChangeDetailWide(std::span<const uint16_t> lhs, std::span<const uint16_t> rhs) noexcept;
+OneChangeResult oneChangeDetailWide(std::span<const uint32_t> lhs, std::span<const uint32_t> rhs) noexcept;
+OneChangeResult oneChangeDetailWide(std::u16string_view lhs, std::u16string_view rhs) noexcept;
+OneChangeResult oneChangeDetailWide(std::u32string_view lhs, std::u32string_view rhs) noexcept;
+
+// Levenshtein distance, full O(n * m) matrix
+unsigned editDistanceSlow(std::string_view lhs, std::string_view rhs) noexcept;
+// editDistance(lhs, rhs) <= k: bit-parallel (short) or diagonal (long) check, k <= 1 goes to oneChangeAuto()
+bool withinEditDistance(std::string_view lhs, std::string_view rhs, unsigned k) noexcept;
+
+// Bit i of out (64 candidates per word) is oneChange(query, candidates[i]), returns count of set bits.
+// out.size() >= (candidates.size() + 63) / 64, nothing is allocated
+size_t oneChangeBatch(std::string_view query, std::span<const std::string_view> candidates,
+                      std::span<uint64_t> out) noexcept;
+
+// Bit i % 32 of out[i / 32] is oneChange(lhs[i], rhs[i]), returns count of set bits. Pairs of strings of at most
+// ONECHANGE_SHORT_BATCH_SIZE bytes are compared 32 at a time: transposed so that a register holds one byte position
+// of 32 pairs (AVX2), longer pairs take the per-pair kernel. lhs.size() == rhs.size(),
+// out.size() >= (lhs.size() + 31) / 32, nothing is allocated
+inline constexpr size_t ONECHANGE_SHORT_BATCH_SIZE = 16;
+size_t oneChangeShortBatch(std::span<const std::string_view> lhs, std::span<const std::string_view> rhs,
+                           std::span<uint32_t> out) noexcept;
+
+// Which paths the one-change kernels take on real traffic, to tune the size thresholds. Compiled in only if the
+// library is built with ONECHANGE_TELEMETRY defined (CMake option of the same name), otherwise the kernels are the
+// same code as without this and the snapshot stays zero. The counters are per thread, a snapshot merges them.
+struct OneChangeTelemetry {
+    static constexpr size_t MISMATCH_BUCKETS = 24;
+
+    uint64_t calls = 0;
+    uint64_t lengthRejects = 0; // sizes differ by 2 or more (or by 1 and the kernel doesn't take insert/delete)
+    uint64_t sameSize = 0;
+    uint64_t diffSize = 0;      // sizes differ by one
+    uint64_t upTo16 = 0;        // the shorter string has at most 16 bytes
+    uint64_t upTo32 = 0;        // 17 to 32 bytes
+    uint64_t fixedKernels = 0;  // taken by the unrolled kernels of oneChangeFixed() from oneChangeAuto()
+    // First mismatch of the Fast kernels: at offset 0 in [0], in [2^(k-1), 2^k) in [k], the last bucket has the rest;
+    // the extra byte at the end of the longer string is at offset size
+    uint64_t firstMismatch[MISMATCH_BUCKETS] = {};
+    uint64_t noMismatch = 0;    // equal strings
+    uint64_t tails = 0;         // the bytes after the last whole vector were compared by the tail
+    uint64_t stagedTails = 0;   // a tail at a page edge was copied to the stack
+    uint64_t byteLoops = 0;     // oneChange()/oneChangeAVX() resolved a block with errors byte by byte
+};
+
+bool oneChangeTelemetryEnabled() noexcept;
+// Sum of all threads since the last reset
+OneChangeTelemetry oneChangeTelemetry() noexcept;
+void resetOneChangeTelemetry() noexcept;
+// {"calls": ..., "firstMismatch": [...], ...}
+std::string toJson(OneChangeTelemetry const& telemetry);
 
 unsigned popcount(__m128i v) noexcept;
-unsigned popcount(__m256i v) noexcept;
\ No newline at end of file
+unsigned popcount(__m256i v) noexcept;
@@ -0,0 +1,139 @@
+#include "index.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#include "fn.h"
+
+
+namespace {
+
+// Polynomial hash sum(s[j] * BASE^(n - 1 - j)) is composable: a deletion variant is
+// prefix * BASE^suffixSize + suffix, so all n variants of a string cost O(n) in total.
+constexpr uint64_t BASE = 0x100000001b3ull;
+
+uint64_t finalize(uint64_t hash, size_t size) noexcept {
+    hash ^= size * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Calls fn(hash) for str and for every distinct one-deletion variant of it
+class NeighborhoodHasher {
+public:
+    template <typename Fn>
+    void operator()(std::string_view str, Fn&& fn) {
+        const auto size = str.size();
+        m_prefix.resize(size + 1);
+        m_suffix.resize(size + 1);
+        m_power.resize(size + 1);
+
+        m_prefix[0] = 0;
+        m_power[0] = 1;
+        for (size_t i = 0; i != size; ++i) {
+            m_prefix[i + 1] = m_prefix[i] * BASE + static_cast<unsigned char>(str[i]);
+            m_power[i + 1] = m_power[i] * BASE;
+        }
+        m_suffix[size] = 0;
+        for (size_t i = size; i != 0; --i) {
+            m_suffix[i - 1] = static_cast<unsigned char>(str[i - 1]) * m_power[size - i] + m_suffix[i];
+        }
+
+        fn(finalize(m_prefix[size], size));
+        for (size_t i = 0; i != size; ++i) {
+            // deleting any symbol of a run gives the same string
+            if (i != 0 && str[i] == str[i - 1]) {
+                continue;
+            }
+            fn(finalize(m_prefix[i] * m_power[size - 1 - i] + m_suffix[i + 1], size - 1));
+        }
+    }
+
+private:
+    std::vector<uint64_t> m_prefix;
+    std::vector<uint64_t> m_suffix;
+    std::vector<uint64_t> m_power;
+};
+
+}
+
+
+OneEditIndex::OneEditIndex(std::span<const std::string_view> entries) {
+    if (entries.size() >= EMPTY) {
+        throw std::length_error("OneEditIndex: too many entries");
+    }
+    size_t bytes = 0;
+    size_t keys = 0;
+    for (auto entry : entries) {
+        bytes += entry.size();
+        keys += entry.size() + 1;
+    }
+
+    m_data.reserve(bytes);
+    m_offsets.reserve(entries.size() + 1);
+    m_offsets.push_back(0);
+    for (auto entry : entries) {
+        m_data.append(entry);
+        m_offsets.push_back(m_data.size());
+    }
+
+    // load factor <= 1/2 keeps linear probing short
+    m_slots.resize(std::bit_ceil(std::max<size_t>(2 * keys, 16)));
+    m_mask = m_slots.size() - 1;
+
+    NeighborhoodHasher hasher;
+    for (id_t id = 0; id != entries.size(); ++id) {
+        hasher((*this)[id], [&](uint64_t hash) {
+            insert(hash, id);
+        });
+    }
+}
+
+void OneEditIndex::insert(uint64_t hash, id_t id) noexcept {
+    for (auto i = hash & m_mask;; i = (i + 1) & m_mask) {
+        if (m_slots[i].id == EMPTY) {
+            m_slots[i] = {static_cast<uint32_t>(hash >> 32), id};
+            return;
+        }
+    }
+}
+
+template <typename Fn>
+void OneEditIndex::forEachHit(uint64_t hash, Fn&& fn) const {
+    const auto tag = static_cast<uint32_t>(hash >> 32);
+    for (auto i = hash & m_mask; m_slots[i].id != EMPTY; i = (i + 1) & m_mask) {
+        if (m_slots[i].tag == tag) {
+            fn(m_slots[i].id);
+        }
+    }
+}
+
+void OneEditIndex::query(std::string_view key, std::vector<id_t>& out) const {
+    out.clear();
+    thread_local NeighborhoodHasher hasher;
+    hasher(key, [&](uint64_t hash) {
+        forEachHit(hash, [&](id_t id) {
+            out.push_back(id);
+        });
+    });
+    // an entry is usually reached through several neighbors, each one is verified once
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    std::erase_if(out, [&](id_t id) { return !oneChangeAuto(key, (*this)[id]); });
+}
+
+std::vector<OneEditIndex::id_t> OneEditIndex::query(std::string_view key) const {
+    std::vector<id_t> result;
+    query(key, result);
+    return result;
+}
+
+size_t OneEditIndex::memoryUsage() const noexcept {
+    return sizeof(*this) + m_data.capacity() + m_offsets.capacity() * sizeof(size_t)
+            + m_slots.capacity() * sizeof(Slot);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Dictionary for "all entries within one edit of a key" lookups (SymSpell-style deletion neighborhood).
+// Every entry is stored under its own hash and the hashes of all its one-deletion variants in a flat
+// open-addressing table. A key matches an entry iff their neighborhoods intersect:
+// key == e (equal), key == del(e) (insert), del(key) == e (delete), del(key) == del(e) (replace).
+// Hash hits are confirmed with oneChangeAuto(), so there are no false positives.
+class OneEditIndex {
+public:
+    using id_t = uint32_t;
+
+    // throws std::length_error for more entries than id_t can number
+    explicit OneEditIndex(std::span<const std::string_view> entries);
+
+    // ids of matching entries in ascending order, out is cleared first
+    void query(std::string_view key, std::vector<id_t>& out) const;
+    std::vector<id_t> query(std::string_view key) const;
+
+    std::string_view operator[](id_t id) const noexcept {
+        return {m_data.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]};
+    }
+
+    size_t size() const noexcept {
+        return m_offsets.size() - 1;
+    }
+
+    size_t memoryUsage() const noexcept;
+
+private:
+    static constexpr id_t EMPTY = ~id_t{0};
+
+    struct Slot {
+        uint32_t tag;
+        id_t id = EMPTY;
+    };
+
+    void insert(uint64_t hash, id_t id) noexcept;
+
+    template <typename Fn>
+    void forEachHit(uint64_t hash, Fn&& fn) const;
+
+    std::string m_data;
+    // size_t: the entries may take more than 4 GiB
+    std::vector<size_t> m_offsets;
+    std::vector<Slot> m_slots;
+    uint64_t m_mask = 0;
+};
@@ -0,0 +1,144 @@
+#include "join.h"
+
+#include <algorithm>
+#include <bit>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "fn.h"
+#include "pool.h"
+
+
+namespace {
+
+using id_t = uint32_t;
+
+// records per partition task, big enough to amortize the task and small enough to stay in L2
+constexpr size_t PART_SIZE = 1 << 15;
+
+enum class Half {
+    Prefix,
+    Suffix,
+};
+
+struct Record {
+    uint64_t hash;
+    id_t id;
+    bool longer;
+};
+
+// For a pair of sizes (size, size) or (size, size + 1) the half that an edit of the other half doesn't touch
+std::string_view halfKey(std::string_view str, size_t size, Half half) noexcept {
+    const auto prefix = size / 2;
+    return half == Half::Prefix ? str.substr(0, prefix) : str.substr(str.size() - (size - prefix));
+}
+
+class SelfJoin {
+public:
+    SelfJoin(std::span<const std::string_view> strings, JoinSink const& sink, WorkStealingPool& pool)
+        : m_strings(strings)
+        , m_sink(sink)
+        , m_pool(pool) {
+        for (id_t id = 0; id != strings.size(); ++id) {
+            m_bySize[strings[id].size()].push_back(id);
+        }
+    }
+
+    void run() {
+        for (auto const& [size, ids] : m_bySize) {
+            for (auto half : {Half::Prefix, Half::Suffix}) {
+                m_pool.submit([this, size = size, half]() {
+                    partition(size, half);
+                });
+            }
+        }
+        m_pool.wait();
+    }
+
+private:
+    // groups sizes `size` and `size + 1` by the hash of the half key and spreads the groups over parts
+    void partition(size_t size, Half half) {
+        auto const& shorter = m_bySize.at(size);
+        const auto next = m_bySize.find(size + 1);
+        const auto total = shorter.size() + (next != m_bySize.end() ? next->second.size() : 0);
+        const unsigned bits = std::bit_width(std::min<size_t>(total / PART_SIZE, 255));
+
+        auto parts = std::make_shared<std::vector<std::vector<Record>>>(size_t{1} << bits);
+        const auto add = [&](id_t id, bool longer) {
+            const auto hash = std::hash<std::string_view>{}(halfKey(m_strings[id], size, half));
+            (*parts)[bits == 0 ? 0 : hash >> (64 - bits)].push_back({hash, id, longer});
+        };
+        for (auto id : shorter) {
+            add(id, false);
+        }
+        if (next != m_bySize.end()) {
+            for (auto id : next->second) {
+                add(id, true);
+            }
+        }
+
+        if (parts->size() == 1) {
+            scan((*parts)[0], size, half);
+            return;
+        }
+        for (size_t i = 0; i != parts->size(); ++i) {
+            m_pool.submit([this, parts, i, size, half]() {
+                scan((*parts)[i], size, half);
+            });
+        }
+    }
+
+    void scan(std::vector<Record>& records, size_t size, Half half) const {
+        std::sort(records.begin(), records.end(), [](Record const& lhs, Record const& rhs) {
+            return lhs.hash < rhs.hash;
+        });
+
+        for (size_t begin = 0, end = 0; begin != records.size(); begin = end) {
+            while (end != records.size() && records[end].hash == records[begin].hash) {
+                ++end;
+            }
+            for (size_t i = begin; i != end; ++i) {
+                for (size_t j = i + 1; j != end; ++j) {
+                    check(records[i], records[j], size, half);
+                }
+            }
+        }
+    }
+
+    void check(Record const& lhs, Record const& rhs, size_t size, Half half) const {
+        if (lhs.longer && rhs.longer) {
+            // both are size + 1, that pair belongs to the next size
+            return;
+        }
+        const auto lhsStr = m_strings[lhs.id];
+        const auto rhsStr = m_strings[rhs.id];
+        if (halfKey(lhsStr, size, half) != halfKey(rhsStr, size, half)) {
+            return;
+        }
+        if (half == Half::Suffix && halfKey(lhsStr, size, Half::Prefix) == halfKey(rhsStr, size, Half::Prefix)) {
+            // the prefix pass reports it
+            return;
+        }
+        if (oneChangeAuto(lhsStr, rhsStr)) {
+            m_sink(std::min(lhs.id, rhs.id), std::max(lhs.id, rhs.id));
+        }
+    }
+
+    std::span<const std::string_view> m_strings;
+    JoinSink const& m_sink;
+    WorkStealingPool& m_pool;
+    std::map<size_t, std::vector<id_t>> m_bySize;
+};
+
+}
+
+
+void oneEditSelfJoin(std::span<const std::string_view> strings, JoinSink const& sink, WorkStealingPool& pool) {
+    SelfJoin(strings, sink, pool).run();
+}
+
+void oneEditSelfJoin(std::span<const std::string_view> strings, JoinSink const& sink) {
+    WorkStealingPool pool;
+    oneEditSelfJoin(strings, sink, pool);
+}
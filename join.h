@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string_view>
+
+class WorkStealingPool;
+
+using JoinSink = std::function<void(size_t lhs, size_t rhs)>;
+
+// Calls sink(i, j), i < j, exactly once for every pair of strings[i], strings[j] within one edit.
+// Only sizes L and L + 1 can pair up, and a single edit leaves either the first or the second half intact,
+// so candidates are grouped by the hash of a half and verified with oneChangeAuto().
+// The sink is called concurrently from the pool threads.
+void oneEditSelfJoin(std::span<const std::string_view> strings, JoinSink const& sink, WorkStealingPool& pool);
+void oneEditSelfJoin(std::span<const std::string_view> strings, JoinSink const& sink);
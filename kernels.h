@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "fn.h"
+
+// Size-specialized kernels from fn.cpp for the other translation units of the library.
+// Same size: lhs.size() == rhs.size(); diff size: lhs.size() > rhs.size().
+
+bool oneChangeSameSizeFastSWAR(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizeFastSWAR(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeSameSizeFast(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizeFast(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeSameSizeFastAVX(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizeFastAVX(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeSameSizeFastAVX512(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizeFastAVX512(std::string_view lhs, std::string_view rhs) noexcept;
+// Same with ONECHANGE_PADDING readable bytes after both strings, see oneChangePadded(); AVX-512 needs no padding
+bool oneChangeSameSizePaddedSWAR(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizePaddedSWAR(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeSameSizePadded(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizePadded(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeSameSizePaddedAVX(std::string_view lhs, std::string_view rhs) noexcept;
+bool oneChangeDiffSizePaddedAVX(std::string_view lhs, std::string_view rhs) noexcept;
+
+// One-edit check of 16/32-bit elements at a SimdLevel for wide.cpp: lhs has minSize + extra elements, rhs has
+// minSize. Delete means lhs[offset] is the extra element.
+OneChangeResult oneEditWide(SimdLevel level, uint16_t const* lhs, uint16_t const* rhs, size_t minSize,
+                            bool extra) noexcept;
+OneChangeResult oneEditWide(SimdLevel level, uint32_t const* lhs, uint32_t const* rhs, size_t minSize,
+                            bool extra) noexcept;
+
+// Longest common extension of [lhs, lhs + size) and [rhs, rhs + size) from extension.cpp: count of equal
+// leading bytes for lce*, count of equal trailing bytes of [lhs - size, lhs) and [rhs - size, rhs) for rlce*
+using ExtensionFn = size_t(*)(char const* lhs, char const* rhs, size_t size) noexcept;
+
+size_t lceScalar(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t rlceScalar(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t lceSSE(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t rlceSSE(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t lceAVX2(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t rlceAVX2(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t lceAVX512(char const* lhs, char const* rhs, size_t size) noexcept;
+size_t rlceAVX512(char const* lhs, char const* rhs, size_t size) noexcept;
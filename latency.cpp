@@ -0,0 +1,89 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+
+namespace {
+
+constexpr uint64_t SUB_COUNT = uint64_t{1} << LatencyHistogram::SUB_BITS;
+constexpr size_t BUCKET_COUNT = (64 - LatencyHistogram::SUB_BITS + 1) * SUB_COUNT;
+
+size_t bucketOf(uint64_t value) noexcept {
+    if (value < SUB_COUNT) {
+        return value;
+    }
+    const unsigned shift = std::bit_width(value) - 1 - LatencyHistogram::SUB_BITS;
+    return (shift + 1) * SUB_COUNT + ((value >> shift) & (SUB_COUNT - 1));
+}
+
+uint64_t bucketMax(size_t bucket) noexcept {
+    if (bucket < SUB_COUNT) {
+        return bucket;
+    }
+    const unsigned shift = bucket / SUB_COUNT - 1;
+    const uint64_t lower = (SUB_COUNT + bucket % SUB_COUNT) << shift;
+    return lower + ((uint64_t{1} << shift) - 1);
+}
+
+} // namespace
+
+
+uint64_t tscOverhead() noexcept {
+    static const uint64_t overhead = [] {
+        auto result = UINT64_MAX;
+        for (int i = 0; i != 10000; ++i) {
+            const auto begin = tscBegin();
+            result = std::min(result, tscEnd() - begin);
+        }
+        return result;
+    }();
+    return overhead;
+}
+
+double tscTicksPerNs() noexcept {
+    static const double ticksPerNs = [] {
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        const auto tscStart = tscBegin();
+        while (Clock::now() - start < std::chrono::milliseconds(20)) {
+        }
+        const auto tscStop = tscEnd();
+        const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        return static_cast<double>(tscStop - tscStart) / elapsed.count();
+    }();
+    return ticksPerNs;
+}
+
+
+LatencyHistogram::LatencyHistogram() : m_buckets(BUCKET_COUNT) {
+}
+
+void LatencyHistogram::record(uint64_t value) noexcept {
+    ++m_buckets[bucketOf(value)];
+    ++m_count;
+    m_max = std::max(m_max, value);
+}
+
+void LatencyHistogram::clear() noexcept {
+    std::fill(m_buckets.begin(), m_buckets.end(), 0);
+    m_count = 0;
+    m_max = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const noexcept {
+    if (m_count == 0) {
+        return 0;
+    }
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(m_count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i != m_buckets.size(); ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketMax(i), m_max);
+        }
+    }
+    return m_max;
+}
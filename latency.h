@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <x86intrin.h>
+
+
+// Per-call latency: serialized TSC reads and a histogram of the samples (bench target only).
+
+// lfence; rdtsc; lfence: the timed code doesn't start before the read
+inline uint64_t tscBegin() noexcept {
+    _mm_lfence();
+    const auto tsc = __rdtsc();
+    _mm_lfence();
+    return tsc;
+}
+
+// rdtscp waits for the timed code, the lfence keeps later code out of the interval
+inline uint64_t tscEnd() noexcept {
+    unsigned aux;
+    const auto tsc = __rdtscp(&aux);
+    _mm_lfence();
+    return tsc;
+}
+
+// Ticks of an empty tscBegin()/tscEnd() interval, the minimum of many; measured once
+uint64_t tscOverhead() noexcept;
+// TSC ticks per nanosecond against steady_clock; measured once
+double tscTicksPerNs() noexcept;
+
+// HDR-style histogram: values below 2^SUB_BITS are counted exactly, each higher power of two is split into
+// 2^SUB_BITS linear buckets, so a percentile is off by at most 1/2^SUB_BITS (3%). The buckets are allocated
+// up front, record() doesn't allocate.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+
+    LatencyHistogram();
+
+    void record(uint64_t value) noexcept;
+    void clear() noexcept;
+
+    uint64_t count() const noexcept {
+        return m_count;
+    }
+
+    uint64_t max() const noexcept {
+        return m_max;
+    }
+
+    // The upper bound of the bucket holding the q-th quantile (q in [0, 1]), 0 without samples
+    uint64_t percentile(double q) const noexcept;
+
+private:
+    std::vector<uint64_t> m_buckets;
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
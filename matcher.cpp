@@ -0,0 +1,158 @@
+#include "matcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "fn.h"
+
+
+namespace {
+
+// offsets of the lhs and rhs index compared as i by each alignment
+constexpr size_t LHS_SHIFT[] = {0, 1, 0};
+constexpr size_t RHS_SHIFT[] = {0, 0, 1};
+
+} // namespace
+
+
+OneChangeMatcher::OneChangeMatcher(size_t lhsSize, size_t rhsSize) noexcept
+    : m_lhsSize(lhsSize)
+    , m_rhsSize(rhsSize) {
+    if (lhsSize == rhsSize) {
+        m_alive = 1u << Replace;
+    } else if (lhsSize == rhsSize + 1) {
+        m_alive = 1u << LhsExtra;
+    } else if (lhsSize + 1 == rhsSize) {
+        m_alive = 1u << RhsExtra;
+    } else {
+        m_alive = 0;
+    }
+}
+
+bool OneChangeMatcher::feedLhs(std::string_view chunk) {
+    assert(m_lhsSize == UNKNOWN_SIZE || m_lhs.size + chunk.size() <= m_lhsSize);
+    feed(m_lhs, chunk);
+    return possible();
+}
+
+bool OneChangeMatcher::feedRhs(std::string_view chunk) {
+    assert(m_rhsSize == UNKNOWN_SIZE || m_rhs.size + chunk.size() <= m_rhsSize);
+    feed(m_rhs, chunk);
+    return possible();
+}
+
+void OneChangeMatcher::feed(Stream& stream, std::string_view chunk) {
+    stream.size += chunk.size();
+    if (!possible()) {
+        stream.begin = stream.size;
+        return;
+    }
+    stream.chunk = chunk;
+    advance();
+    trim();
+}
+
+bool OneChangeMatcher::finish() const noexcept {
+    const auto lhsSize = m_lhs.size;
+    const auto rhsSize = m_rhs.size;
+    assert(m_lhsSize == UNKNOWN_SIZE || (lhsSize == m_lhsSize && rhsSize == m_rhsSize));
+    if (lhsSize == rhsSize) {
+        return m_alive & (1u << Replace);
+    } else if (lhsSize == rhsSize + 1) {
+        return m_alive & (1u << LhsExtra);
+    } else if (lhsSize + 1 == rhsSize) {
+        return m_alive & (1u << RhsExtra);
+    }
+    return false;
+}
+
+void OneChangeMatcher::advance() noexcept {
+    if (m_mismatch == NO_MISMATCH) {
+        // the streams are aligned, the common prefix of what both sides have is skipped
+        auto& next = m_next[Replace];
+        const auto count = std::min(m_lhs.size, m_rhs.size) - next;
+        const auto equal = commonPrefix(next, next, count);
+        next += equal;
+        if (equal == count) {
+            return;
+        }
+        m_mismatch = next;
+        m_next[LhsExtra] = m_mismatch;
+        m_next[RhsExtra] = m_mismatch;
+        m_next[Replace] = m_mismatch + 1;
+    }
+    for (unsigned alignment = 0; alignment != ALIGNMENT_COUNT; ++alignment) {
+        if (m_alive & (1u << alignment)) {
+            advance(alignment);
+        }
+    }
+}
+
+void OneChangeMatcher::advance(unsigned alignment) noexcept {
+    auto& next = m_next[alignment];
+    const auto lhsFrom = next + LHS_SHIFT[alignment];
+    const auto rhsFrom = next + RHS_SHIFT[alignment];
+    if (lhsFrom >= m_lhs.size || rhsFrom >= m_rhs.size) {
+        return;
+    }
+    const auto count = std::min(m_lhs.size - lhsFrom, m_rhs.size - rhsFrom);
+    const auto equal = commonPrefix(lhsFrom, rhsFrom, count);
+    next += equal;
+    if (equal != count) {
+        m_alive &= ~(1u << alignment);
+    }
+}
+
+// commonPrefix() of the stream bytes from lhsFrom and rhsFrom, piece by piece
+size_t OneChangeMatcher::commonPrefix(size_t lhsFrom, size_t rhsFrom, size_t count) const noexcept {
+    size_t equal = 0;
+    while (equal != count) {
+        const auto lhs = m_lhs.piece(lhsFrom + equal);
+        const auto rhs = m_rhs.piece(rhsFrom + equal);
+        const auto size = std::min({lhs.size(), rhs.size(), count - equal});
+        const auto prefix = ::commonPrefix(lhs.substr(0, size), rhs.substr(0, size));
+        equal += prefix;
+        if (prefix != size) {
+            break;
+        }
+    }
+    return equal;
+}
+
+// keeps the bytes some alignment hasn't compared yet; a compared prefix of buffer is erased once it is as long as
+// the rest, so each byte is moved O(1) times on average
+void OneChangeMatcher::trim() {
+    if (!possible()) {
+        m_lhs = {{}, {}, m_lhs.size, m_lhs.size};
+        m_rhs = {{}, {}, m_rhs.size, m_rhs.size};
+        return;
+    }
+    size_t lhsFrom = m_lhs.size;
+    size_t rhsFrom = m_rhs.size;
+    if (m_mismatch == NO_MISMATCH) {
+        lhsFrom = rhsFrom = m_next[Replace];
+    } else {
+        for (unsigned alignment = 0; alignment != ALIGNMENT_COUNT; ++alignment) {
+            if (m_alive & (1u << alignment)) {
+                lhsFrom = std::min(lhsFrom, m_next[alignment] + LHS_SHIFT[alignment]);
+                rhsFrom = std::min(rhsFrom, m_next[alignment] + RHS_SHIFT[alignment]);
+            }
+        }
+    }
+    for (auto [stream, from] : {std::pair{&m_lhs, lhsFrom}, std::pair{&m_rhs, rhsFrom}}) {
+        const auto drop = std::min(from, stream->size) - stream->begin;
+        auto& buffer = stream->buffer;
+        if (drop >= buffer.size()) {
+            buffer.assign(stream->chunk.substr(drop - buffer.size()));
+            stream->begin += drop;
+        } else {
+            if (drop >= buffer.size() - drop) {
+                buffer.erase(0, drop);
+                stream->begin += drop;
+            }
+            buffer.append(stream->chunk);
+        }
+        stream->chunk = {};
+    }
+}
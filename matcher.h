@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+// oneChange() of two streams that arrive in chunks, e.g. network fragments: the bytes are compared as soon as both
+// sides have them. Until the first mismatch the streams are aligned. A mismatch at p leaves three alignments:
+// replace (lhs[i] vs rhs[i] after p), lhs has the extra symbol (lhs[i + 1] vs rhs[i] from p) and rhs has it
+// (lhs[i] vs rhs[i + 1] from p). Each alignment is dropped at its first mismatch. The bytes that one side has and
+// the other hasn't reached yet (plus up to two) are kept, and a compared prefix of them is erased only once it is
+// as long as the rest: buffered() stays below 2 * (skew + 2), twice the skew of the streams.
+class OneChangeMatcher {
+public:
+    OneChangeMatcher() = default;
+    // With sizes known up front only the alignment they allow is followed, sizes that differ by more than one
+    // are rejected at once
+    OneChangeMatcher(size_t lhsSize, size_t rhsSize) noexcept;
+
+    // false once the streams can't be one change apart whatever follows, later chunks are then only counted
+    bool feedLhs(std::string_view chunk);
+    bool feedRhs(std::string_view chunk);
+
+    bool possible() const noexcept {
+        return m_alive != 0;
+    }
+
+    // The verdict for the streams fed so far, they must have the declared sizes if there are any
+    bool finish() const noexcept;
+
+    // bytes held for the comparisons to come
+    size_t buffered() const noexcept {
+        return m_lhs.buffer.size() + m_rhs.buffer.size();
+    }
+
+private:
+    enum Alignment : unsigned { Replace, LhsExtra, RhsExtra, ALIGNMENT_COUNT };
+
+    // The stream bytes [begin, size): the kept ones in buffer, then the chunk being fed. The chunk is compared
+    // in place, only its bytes that are still needed are copied to buffer afterwards.
+    struct Stream {
+        std::string buffer;
+        std::string_view chunk;
+        size_t begin = 0;
+        size_t size = 0;
+
+        // the contiguous bytes from the stream offset on
+        std::string_view piece(size_t from) const noexcept {
+            const auto kept = from - begin;
+            return kept < buffer.size() ? std::string_view(buffer).substr(kept) : chunk.substr(kept - buffer.size());
+        }
+    };
+
+    static constexpr unsigned ALL_ALIGNMENTS = (1u << ALIGNMENT_COUNT) - 1;
+    static constexpr size_t NO_MISMATCH = ~size_t{0};
+    static constexpr size_t UNKNOWN_SIZE = ~size_t{0};
+
+    void feed(Stream& stream, std::string_view chunk);
+    void advance() noexcept;
+    void advance(unsigned alignment) noexcept;
+    size_t commonPrefix(size_t lhsFrom, size_t rhsFrom, size_t count) const noexcept;
+    void trim();
+
+    Stream m_lhs;
+    Stream m_rhs;
+    // the alignments still possible, before the first mismatch the ones the sizes allow
+    unsigned m_alive = ALL_ALIGNMENTS;
+    size_t m_mismatch = NO_MISMATCH;
+    // next compared index i of each alignment, before the first mismatch only m_next[Replace] is used
+    size_t m_next[ALIGNMENT_COUNT] = {};
+    // declared sizes
+    size_t m_lhsSize = UNKNOWN_SIZE;
+    size_t m_rhsSize = UNKNOWN_SIZE;
+};
@@ -0,0 +1,188 @@
+#include "pairs.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "fn.h"
+#include "pool.h"
+
+
+namespace {
+
+struct ChunkResult {
+    std::vector<uint64_t> bitmap;
+    std::vector<std::string_view> lines; // Matches/Rejects only
+    PairStats stats;
+    bool ready = false;
+};
+
+void processChunk(std::string_view chunk, PairOutput mode, ChunkResult& result) {
+    size_t word = 0;
+    unsigned bit = 0;
+    while (!chunk.empty()) {
+        auto newline = chunk.find('\n');
+        auto line = chunk.substr(0, newline);
+        chunk.remove_prefix(newline == std::string_view::npos ? chunk.size() : newline + 1);
+        const auto fullLine = line;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        bool match = false;
+        const auto tab = line.find('\t');
+        if (tab == std::string_view::npos) {
+            ++result.stats.malformed;
+        } else {
+            match = oneChangeAuto(line.substr(0, tab), line.substr(tab + 1));
+        }
+
+        ++result.stats.pairs;
+        result.stats.matches += match;
+        switch (mode) {
+            case PairOutput::Bitmap:
+                word |= uint64_t{match} << bit;
+                if (++bit == 64) {
+                    result.bitmap.push_back(word);
+                    word = 0;
+                    bit = 0;
+                }
+                break;
+            case PairOutput::Matches:
+            case PairOutput::Rejects:
+                if (match == (mode == PairOutput::Matches)) {
+                    result.lines.push_back(fullLine);
+                }
+                break;
+            case PairOutput::None:
+                break;
+        }
+    }
+    if (bit != 0) {
+        result.bitmap.push_back(word);
+    }
+}
+
+// Appends chunk bitmaps that don't end on a byte boundary into one continuous bit stream
+class BitmapWriter {
+public:
+    explicit BitmapWriter(FILE* out) noexcept
+        : m_out(out) {
+    }
+
+    void append(std::vector<uint64_t> const& words, size_t bits) {
+        for (size_t i = 0; bits != 0; ++i) {
+            const auto count = std::min<size_t>(bits, 64);
+            push(words[i], count);
+            bits -= count;
+        }
+    }
+
+    void finish() {
+        if (m_bits != 0) {
+            flushBytes((m_bits + 7) / 8);
+        }
+        fwrite(m_buffer.data(), 1, m_buffer.size(), m_out);
+        m_buffer.clear();
+    }
+
+private:
+    void push(uint64_t word, size_t count) {
+        // m_pending keeps fewer than 8 bits between calls
+        m_pending |= static_cast<unsigned __int128>(word) << m_bits;
+        m_bits += count;
+        flushBytes(m_bits / 8);
+        if (m_buffer.size() >= PAIR_CHUNK_SIZE) {
+            fwrite(m_buffer.data(), 1, m_buffer.size(), m_out);
+            m_buffer.clear();
+        }
+    }
+
+    void flushBytes(size_t bytes) {
+        for (size_t i = 0; i != bytes; ++i) {
+            m_buffer.push_back(static_cast<char>(m_pending & 0xff));
+            m_pending >>= 8;
+        }
+        m_bits -= std::min(m_bits, bytes * 8);
+    }
+
+    FILE* m_out;
+    std::vector<char> m_buffer;
+    unsigned __int128 m_pending = 0;
+    size_t m_bits = 0;
+};
+
+} // namespace
+
+
+std::vector<std::string_view> splitPairChunks(std::string_view input, size_t chunkSize) {
+    std::vector<std::string_view> chunks;
+    while (!input.empty()) {
+        auto end = std::min(chunkSize, input.size());
+        if (end != input.size()) {
+            const auto newline = input.find('\n', end - 1);
+            end = newline == std::string_view::npos ? input.size() : newline + 1;
+        }
+        chunks.push_back(input.substr(0, end));
+        input.remove_prefix(end);
+    }
+    return chunks;
+}
+
+PairStats checkPairs(std::string_view input, PairOutput mode, FILE* out, WorkStealingPool& pool, size_t chunkSize) {
+    const auto chunks = splitPairChunks(input, chunkSize);
+    // chunk i goes to slot i % slots.size(), it is submitted once the writer has released chunk i - slots.size()
+    const size_t inFlight = 2 * std::max(pool.size(), 1u);
+    std::vector<ChunkResult> slots(std::min(inFlight, chunks.size()));
+    std::mutex mutex;
+    std::condition_variable chunkReady;
+    const auto submit = [&](size_t i) {
+        pool.submit([&, i]() {
+            ChunkResult result;
+            processChunk(chunks[i], mode, result);
+            {
+                std::lock_guard lock(mutex);
+                slots[i % slots.size()] = std::move(result);
+                slots[i % slots.size()].ready = true;
+            }
+            chunkReady.notify_one();
+        });
+    };
+    for (size_t i = 0; i != std::min(slots.size(), chunks.size()); ++i) {
+        submit(i);
+    }
+
+    // the writer follows the workers in input order
+    PairStats stats;
+    BitmapWriter bitmap(out);
+    for (size_t i = 0; i != chunks.size(); ++i) {
+        auto& result = slots[i % slots.size()];
+        {
+            std::unique_lock lock(mutex);
+            chunkReady.wait(lock, [&]() { return result.ready; });
+        }
+        stats.pairs += result.stats.pairs;
+        stats.matches += result.stats.matches;
+        stats.malformed += result.stats.malformed;
+        if (mode == PairOutput::Bitmap) {
+            bitmap.append(result.bitmap, result.stats.pairs);
+        }
+        for (auto line : result.lines) {
+            fwrite(line.data(), 1, line.size(), out);
+            fputc('\n', out);
+        }
+        {
+            std::lock_guard lock(mutex);
+            result = {};
+        }
+        if (i + slots.size() < chunks.size()) {
+            submit(i + slots.size());
+        }
+    }
+    pool.wait();
+    if (mode == PairOutput::Bitmap) {
+        bitmap.finish();
+    }
+    return stats;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+class WorkStealingPool;
+
+// The pipeline of onechange-cli: lines of lhs<TAB>rhs are split into line-aligned chunks, the chunks are checked
+// in parallel with oneChangeAuto() on string_views into the input and the results are written in input order.
+
+enum class PairOutput {
+    None,
+    Bitmap,  // bit i (LSB first) is the verdict for line i
+    Matches, // lines that are one edit apart, as is
+    Rejects, // lines that aren't
+};
+
+struct PairStats {
+    size_t pairs = 0;
+    size_t matches = 0;
+    size_t malformed = 0; // lines without a tab, counted as not one edit apart
+};
+
+constexpr size_t PAIR_CHUNK_SIZE = 8 << 20;
+
+// Ranges of input of about chunkSize bytes, every one ends right after a '\n' (or at the end of the input)
+std::vector<std::string_view> splitPairChunks(std::string_view input, size_t chunkSize = PAIR_CHUNK_SIZE);
+
+// At most 2 * pool.size() chunks are checked or wait for the writer at a time, so the memory held for the results
+// doesn't grow with the input. Write errors are left in the error flag of out.
+PairStats checkPairs(std::string_view input, PairOutput mode, FILE* out, WorkStealingPool& pool,
+                     size_t chunkSize = PAIR_CHUNK_SIZE);
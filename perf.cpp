@@ -0,0 +1,131 @@
+#include "perf.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+#ifdef __linux__
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cacheMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr std::array<EventConfig, PerfCounters::EVENT_COUNT> EVENTS{{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+}};
+
+int openEvent(EventConfig event) noexcept {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+} // namespace
+
+
+PerfCounters::PerfCounters() noexcept {
+    m_fds.fill(-1);
+#ifdef __linux__
+    for (unsigned i = 0; i != EVENT_COUNT; ++i) {
+        m_fds[i] = openEvent(EVENTS[i]);
+        if (m_fds[i] < 0 && m_error.empty()) {
+            m_error = std::string(toString(static_cast<Event>(i))) + ": " + std::strerror(errno);
+        }
+    }
+#else
+    m_error = "perf_event needs Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available() const noexcept {
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() noexcept {
+#ifdef __linux__
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfCounters::Values PerfCounters::stop() noexcept {
+    Values values;
+#ifdef __linux__
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (unsigned i = 0; i != EVENT_COUNT; ++i) {
+        // value, time enabled, time running
+        uint64_t data[3] = {};
+        if (m_fds[i] < 0 || read(m_fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            continue;
+        }
+        values.count[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        values.valid[i] = true;
+    }
+#endif
+    return values;
+}
+
+const char* toString(PerfCounters::Event event) noexcept {
+    switch (event) {
+        case PerfCounters::Cycles: return "cycles";
+        case PerfCounters::Instructions: return "instructions";
+        case PerfCounters::BranchMisses: return "branch-misses";
+        case PerfCounters::L1DMisses: return "L1-dcache-load-misses";
+        case PerfCounters::LLCMisses: return "LLC-load-misses";
+        default: return "unknown";
+    }
+}
+
+bool perfCountersRequested() noexcept {
+    const char* env = std::getenv("ONECHANGE_PERF");
+    return env && std::strcmp(env, "0") != 0;
+}
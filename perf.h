@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+
+// Hardware counters of the calling thread from Linux perf_event (bench target only).
+
+// Cycles, instructions, branch misses, L1D read misses and last level cache read misses, user space only.
+// Each event is opened on its own: an event the kernel doesn't give (no PMU in a VM, perf_event_paranoid,
+// seccomp, not Linux) stays unavailable, the others still count. When the kernel multiplexes the events
+// their values are scaled to the whole measured interval.
+class PerfCounters {
+public:
+    enum Event : unsigned {
+        Cycles,
+        Instructions,
+        BranchMisses,
+        L1DMisses,
+        LLCMisses,
+        EVENT_COUNT
+    };
+
+    struct Values {
+        std::array<double, EVENT_COUNT> count{};
+        std::array<bool, EVENT_COUNT> valid{};
+    };
+
+    PerfCounters() noexcept;
+    ~PerfCounters();
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    // at least one event is open
+    bool available() const noexcept;
+    // why the first event that isn't open failed, empty if all are open
+    std::string const& error() const noexcept {
+        return m_error;
+    }
+
+    // resets and enables the events
+    void start() noexcept;
+    // disables the events and reads them
+    Values stop() noexcept;
+
+private:
+    std::array<int, EVENT_COUNT> m_fds;
+    std::string m_error;
+};
+
+const char* toString(PerfCounters::Event event) noexcept;
+
+// ONECHANGE_PERF is set and isn't "0"
+bool perfCountersRequested() noexcept;
@@ -0,0 +1,108 @@
+#include "pool.h"
+
+#include <algorithm>
+
+
+namespace {
+
+// index of the queue owned by the current thread, or -1 outside of the pool
+thread_local int t_worker = -1;
+
+}
+
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    threads = std::max(threads, 1u);
+    for (unsigned i = 0; i != threads; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i != threads; ++i) {
+        m_threads.emplace_back([this, i]() {
+            t_worker = i;
+            work(i);
+        });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_hasWork.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    const unsigned target = t_worker >= 0
+            ? static_cast<unsigned>(t_worker)
+            : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    // counted before it's visible, so a fast worker never takes m_queued below zero
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_queued;
+        ++m_pending;
+    }
+    {
+        std::lock_guard lock(m_queues[target]->mutex);
+        m_queues[target]->tasks.push_back(std::move(task));
+    }
+    m_hasWork.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+}
+
+bool WorkStealingPool::tryRunOne(unsigned self) {
+    Task task;
+    for (unsigned i = 0; i != m_queues.size() && !task; ++i) {
+        auto& queue = *m_queues[(self + i) % m_queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        --m_queued;
+    }
+    task();
+
+    bool done;
+    {
+        std::lock_guard lock(m_mutex);
+        done = --m_pending == 0;
+    }
+    if (done) {
+        m_done.notify_all();
+    }
+    return true;
+}
+
+void WorkStealingPool::work(unsigned self) {
+    while (true) {
+        if (tryRunOne(self)) {
+            continue;
+        }
+        std::unique_lock lock(m_mutex);
+        m_hasWork.wait(lock, [this]() { return m_stop || m_queued != 0; });
+        if (m_stop && m_queued == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of workers with a deque per worker: a worker takes its newest task first and
+// steals the oldest task of the others when its own deque is empty.
+// Tasks may submit more tasks, wait() returns when all of them are done.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(WorkStealingPool const&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+    void submit(Task task);
+    void wait();
+
+    unsigned size() const noexcept {
+        return m_threads.size();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool tryRunOne(unsigned self);
+    void work(unsigned self);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<unsigned> m_nextQueue{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_hasWork;
+    std::condition_variable m_done;
+    size_t m_queued = 0; // guarded by m_mutex
+    size_t m_pending = 0; // guarded by m_mutex
+    bool m_stop = false;
+};
@@ -0,0 +1,214 @@
+#include "search.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+#include "fn.h"
+#include "simd.h"
+
+
+namespace {
+
+// Scans of one SimdLevel: in mask(), bit j is set if needle occurs at text + j (j < 64), text[0, 63 + needle.size())
+// is readable. The first and last bytes of needle filter the positions, memcmp confirms the rest.
+[[gnu::always_inline]] inline uint64_t confirm(uint64_t candidates, const char* text, std::string_view needle) noexcept {
+    uint64_t hits = 0;
+    for (; candidates != 0; candidates &= candidates - 1) {
+        const auto j = std::countr_zero(candidates);
+        if (memcmp(text + j + 1, needle.data() + 1, needle.size() - 1) == 0) {
+            hits |= uint64_t{1} << j;
+        }
+    }
+    return hits;
+}
+
+struct HitsScalar {
+    [[gnu::always_inline]] static uint64_t mask(const char* text, std::string_view needle) noexcept {
+        const auto last = needle.size() - 1;
+        uint64_t candidates = 0;
+        for (size_t j = 0; j != 64; ++j) {
+            candidates |= uint64_t{text[j] == needle[0] && text[j + last] == needle[last]} << j;
+        }
+        return confirm(candidates, text, needle);
+    }
+};
+
+struct HitsSSE {
+    static uint64_t mask(const char* text, std::string_view needle) noexcept;
+};
+
+struct HitsAVX2 {
+    static uint64_t mask(const char* text, std::string_view needle) noexcept;
+};
+
+struct HitsAVX512 {
+    static uint64_t mask(const char* text, std::string_view needle) noexcept;
+};
+
+ONECHANGE_TARGET_SSE_BEGIN
+inline uint64_t HitsSSE::mask(const char* text, std::string_view needle) noexcept {
+    const auto last = needle.size() - 1;
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i lastByte = _mm_set1_epi8(needle[last]);
+    uint64_t candidates = 0;
+    for (size_t j = 0; j != 64; j += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + j));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + j + last));
+        __m128i both = _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, lastByte));
+        candidates |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(both))} << j;
+    }
+    return confirm(candidates, text, needle);
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX2_BEGIN
+inline uint64_t HitsAVX2::mask(const char* text, std::string_view needle) noexcept {
+    const auto last = needle.size() - 1;
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i lastByte = _mm256_set1_epi8(needle[last]);
+    uint64_t candidates = 0;
+    for (size_t j = 0; j != 64; j += 32) {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + j));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + j + last));
+        __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, lastByte));
+        candidates |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(both))} << j;
+    }
+    return confirm(candidates, text, needle);
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+inline uint64_t HitsAVX512::mask(const char* text, std::string_view needle) noexcept {
+    const auto last = needle.size() - 1;
+    __m512i head = _mm512_loadu_si512(text);
+    __m512i tail = _mm512_loadu_si512(text + last);
+    const uint64_t candidates = _mm512_cmpeq_epi8_mask(head, _mm512_set1_epi8(needle[0]))
+            & _mm512_cmpeq_epi8_mask(tail, _mm512_set1_epi8(needle[last]));
+    return confirm(candidates, text, needle);
+}
+ONECHANGE_TARGET_END
+
+// Occurrences of needle at text + pos + j (j < 64) within text: the SIMD scan while its loads stay in text,
+// the positions near the end one by one
+template <typename Hits>
+[[gnu::always_inline]] inline uint64_t hitsAt(std::string_view text, size_t pos, std::string_view needle) noexcept {
+    if (pos + 63 + needle.size() <= text.size()) [[likely]] {
+        return Hits::mask(text.data() + pos, needle);
+    }
+    uint64_t result = 0;
+    for (size_t j = 0; j != 64 && pos + j + needle.size() <= text.size(); ++j) {
+        result |= uint64_t{text.substr(pos + j, needle.size()) == needle} << j;
+    }
+    return result;
+}
+
+// Window pos: the edit is after the first half if text[pos, pos + half) is it (all three sizes), otherwise
+// the second half ends the window: it is at pos + half - 1 (size - 1), pos + half (size) or pos + half + 1.
+// Inlined into the per-level entries below like the kernels of fn.cpp.
+template <typename Hits, typename Report>
+[[gnu::always_inline]] inline void findOneEditT(std::string_view text, std::string_view pattern,
+                                                Report const& report) {
+    const auto size = pattern.size();
+    const auto half = size / 2;
+    const auto prefix = pattern.substr(0, half);
+    const auto suffix = pattern.substr(half);
+    const auto lastPos = text.size() - (size - 1);
+    uint64_t suffixHits = hitsAt<Hits>(text, half - 1, suffix);
+    for (size_t pos = 0; pos <= lastPos; pos += 64) {
+        const auto prefixHits = hitsAt<Hits>(text, pos, prefix);
+        const auto nextSuffixHits = hitsAt<Hits>(text, pos + 64 + half - 1, suffix);
+        const uint64_t shorter = suffixHits;
+        const uint64_t same = (suffixHits >> 1) | (nextSuffixHits << 63);
+        const uint64_t longer = (suffixHits >> 2) | (nextSuffixHits << 62);
+        suffixHits = nextSuffixHits;
+
+        for (uint64_t windows = prefixHits | shorter | same | longer; windows != 0; windows &= windows - 1) {
+            const auto j = std::countr_zero(windows);
+            const uint64_t bit = uint64_t{1} << j;
+            if ((prefixHits | shorter) & bit) {
+                report(pos + j, size - 1);
+            }
+            if ((prefixHits | same) & bit) {
+                report(pos + j, size);
+            }
+            if ((prefixHits | longer) & bit) {
+                report(pos + j, size + 1);
+            }
+        }
+    }
+}
+
+// Verifies a candidate window, outside the target regions (oneChangeAuto() dispatches itself)
+class WindowReport {
+public:
+    WindowReport(std::string_view text, std::string_view pattern, FindSink const& sink) noexcept
+        : m_text(text)
+        , m_pattern(pattern)
+        , m_sink(sink) {
+    }
+
+    void operator()(size_t pos, size_t size) const {
+        if (pos + size <= m_text.size() && oneChangeAuto(m_text.substr(pos, size), m_pattern)) {
+            m_sink(pos, size);
+        }
+    }
+
+private:
+    std::string_view m_text;
+    std::string_view m_pattern;
+    FindSink const& m_sink;
+};
+
+void findOneEditScalar(std::string_view text, std::string_view pattern, WindowReport const& report) {
+    findOneEditT<HitsScalar>(text, pattern, report);
+}
+
+ONECHANGE_TARGET_SSE_BEGIN
+void findOneEditSSE(std::string_view text, std::string_view pattern, WindowReport const& report) {
+    findOneEditT<HitsSSE>(text, pattern, report);
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX2_BEGIN
+void findOneEditAVX2(std::string_view text, std::string_view pattern, WindowReport const& report) {
+    findOneEditT<HitsAVX2>(text, pattern, report);
+}
+ONECHANGE_TARGET_END
+
+ONECHANGE_TARGET_AVX512_BEGIN
+void findOneEditAVX512(std::string_view text, std::string_view pattern, WindowReport const& report) {
+    findOneEditT<HitsAVX512>(text, pattern, report);
+}
+ONECHANGE_TARGET_END
+
+} // namespace
+
+
+void findOneEdit(std::string_view text, std::string_view pattern, FindSink const& sink) {
+    const WindowReport report(text, pattern, sink);
+    const auto size = pattern.size();
+    if (size < 2) {
+        // a half would be empty: every window is a candidate
+        for (size_t pos = 0; pos <= text.size(); ++pos) {
+            for (size_t windowSize = size == 0 ? 0 : size - 1; windowSize <= size + 1; ++windowSize) {
+                report(pos, windowSize);
+            }
+        }
+        return;
+    } else if (size - 1 > text.size()) {
+        return;
+    }
+
+    switch (oneChangeAutoLevel()) {
+        case SimdLevel::AVX512:
+            return findOneEditAVX512(text, pattern, report);
+        case SimdLevel::AVX2:
+            return findOneEditAVX2(text, pattern, report);
+        case SimdLevel::SSE:
+            return findOneEditSSE(text, pattern, report);
+        default:
+            return findOneEditScalar(text, pattern, report);
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+using FindSink = std::function<void(size_t pos, size_t size)>;
+
+// Calls sink(pos, size) for every window text[pos, pos + size) within one edit of pattern (size is pattern.size()
+// - 1, pattern.size() or pattern.size() + 1), ordered by pos and then size.
+// Pigeonhole filter: a single edit leaves one half of the pattern intact, so only windows that start with the first
+// half or end with the second one are verified with oneChangeAuto(). The halves are found 64 text positions at a
+// time by a first/last byte compare at the SIMD level of oneChangeAuto().
+void findOneEdit(std::string_view text, std::string_view pattern, FindSink const& sink);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-function instruction set selection. Everything between BEGIN and END (including lambdas and
+// templates defined there) is compiled for the given ISA, the rest of the TU stays baseline x86-64.
+// Callers must check detectSimdLevel() before entering such a function.
+
+#define ONECHANGE_SSE_FEATURES "sse4.2,popcnt"
+#define ONECHANGE_AVX2_FEATURES "avx2,bmi,bmi2,popcnt"
+#define ONECHANGE_AVX512_FEATURES "avx512f,avx512bw,avx512vl,avx2,bmi,bmi2,popcnt"
+
+#define ONECHANGE_PRAGMA(x) _Pragma(#x)
+
+#if defined(__clang__)
+#define ONECHANGE_TARGET_BEGIN(features) \
+    ONECHANGE_PRAGMA(clang attribute push(__attribute__((target(features))), apply_to = function))
+#define ONECHANGE_TARGET_END ONECHANGE_PRAGMA(clang attribute pop)
+#else
+#define ONECHANGE_TARGET_BEGIN(features) \
+    ONECHANGE_PRAGMA(GCC push_options) ONECHANGE_PRAGMA(GCC target(features))
+#define ONECHANGE_TARGET_END ONECHANGE_PRAGMA(GCC pop_options)
+#endif
+
+#define ONECHANGE_TARGET_SSE_BEGIN ONECHANGE_TARGET_BEGIN(ONECHANGE_SSE_FEATURES)
+#define ONECHANGE_TARGET_AVX2_BEGIN ONECHANGE_TARGET_BEGIN(ONECHANGE_AVX2_FEATURES)
+#define ONECHANGE_TARGET_AVX512_BEGIN ONECHANGE_TARGET_BEGIN(ONECHANGE_AVX512_FEATURES)
+
+// Smallest page size of the targets: a load that stays in the page of its first readable byte can't fault.
+// Not PAGE_SIZE, which some libcs (musl) define as a macro.
+inline constexpr uintptr_t ONECHANGE_PAGE_SIZE = 4096;
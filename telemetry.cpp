@@ -0,0 +1,115 @@
+#include "telemetry.h"
+
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+
+namespace telemetry {
+constinit thread_local Counters t_counters{};
+} // namespace telemetry
+
+namespace {
+
+using telemetry::Counters;
+
+struct Field {
+    const char* name;
+    uint64_t OneChangeTelemetry::* total;
+    std::atomic<uint64_t> Counters::* counter;
+};
+
+constexpr Field FIELDS[] = {
+        {"calls", &OneChangeTelemetry::calls, &Counters::calls},
+        {"lengthRejects", &OneChangeTelemetry::lengthRejects, &Counters::lengthRejects},
+        {"sameSize", &OneChangeTelemetry::sameSize, &Counters::sameSize},
+        {"diffSize", &OneChangeTelemetry::diffSize, &Counters::diffSize},
+        {"upTo16", &OneChangeTelemetry::upTo16, &Counters::upTo16},
+        {"upTo32", &OneChangeTelemetry::upTo32, &Counters::upTo32},
+        {"fixedKernels", &OneChangeTelemetry::fixedKernels, &Counters::fixedKernels},
+        {"noMismatch", &OneChangeTelemetry::noMismatch, &Counters::noMismatch},
+        {"tails", &OneChangeTelemetry::tails, &Counters::tails},
+        {"stagedTails", &OneChangeTelemetry::stagedTails, &Counters::stagedTails},
+        {"byteLoops", &OneChangeTelemetry::byteLoops, &Counters::byteLoops},
+};
+
+std::mutex g_mutex;
+std::vector<Counters*> g_threads;
+OneChangeTelemetry g_exited; // threads that have exited
+OneChangeTelemetry g_reset;  // the snapshot of the last reset
+
+void addTo(OneChangeTelemetry& total, Counters const& counters) noexcept {
+    for (auto const& field : FIELDS) {
+        total.*field.total += (counters.*field.counter).load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i != OneChangeTelemetry::MISMATCH_BUCKETS; ++i) {
+        total.firstMismatch[i] += counters.firstMismatch[i].load(std::memory_order_relaxed);
+    }
+}
+
+// under g_mutex
+OneChangeTelemetry total() noexcept {
+    auto result = g_exited;
+    for (auto const* counters : g_threads) {
+        addTo(result, *counters);
+    }
+    return result;
+}
+
+struct Enrollment {
+    ~Enrollment() {
+        std::lock_guard lock(g_mutex);
+        addTo(g_exited, telemetry::t_counters);
+        std::erase(g_threads, &telemetry::t_counters);
+    }
+};
+
+} // namespace
+
+
+void telemetry::enroll() noexcept {
+    thread_local Enrollment enrollment;
+    std::lock_guard lock(g_mutex);
+    g_threads.push_back(&t_counters);
+    t_counters.enrolled = true;
+}
+
+bool oneChangeTelemetryEnabled() noexcept {
+#ifdef ONECHANGE_TELEMETRY
+    return true;
+#else
+    return false;
+#endif
+}
+
+OneChangeTelemetry oneChangeTelemetry() noexcept {
+    std::lock_guard lock(g_mutex);
+    auto result = total();
+    for (auto const& field : FIELDS) {
+        result.*field.total -= g_reset.*field.total;
+    }
+    for (size_t i = 0; i != OneChangeTelemetry::MISMATCH_BUCKETS; ++i) {
+        result.firstMismatch[i] -= g_reset.firstMismatch[i];
+    }
+    return result;
+}
+
+// the counters of running threads are written without locks, so they aren't zeroed but subtracted
+void resetOneChangeTelemetry() noexcept {
+    std::lock_guard lock(g_mutex);
+    g_reset = total();
+}
+
+std::string toJson(OneChangeTelemetry const& telemetry) {
+    std::ostringstream json;
+    json << "{";
+    for (auto const& field : FIELDS) {
+        json << '"' << field.name << "\": " << telemetry.*field.total << ", ";
+    }
+    json << R"("firstMismatch": [)";
+    for (size_t i = 0; i != OneChangeTelemetry::MISMATCH_BUCKETS; ++i) {
+        json << (i == 0 ? "" : ", ") << telemetry.firstMismatch[i];
+    }
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#include "fn.h"
+
+// Hot-path counters of the kernels in fn.cpp behind OneChangeTelemetry. Without ONECHANGE_TELEMETRY every
+// ONECHANGE_COUNT* macro is empty and its arguments aren't evaluated, so the kernels compile to the same code.
+
+namespace telemetry {
+
+// The counters of one thread, in their own cache lines. Only the thread writes them (a load and a store, no locked
+// add), oneChangeTelemetry() reads them from other threads.
+struct alignas(64) Counters {
+    bool enrolled;
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> lengthRejects;
+    std::atomic<uint64_t> sameSize;
+    std::atomic<uint64_t> diffSize;
+    std::atomic<uint64_t> upTo16;
+    std::atomic<uint64_t> upTo32;
+    std::atomic<uint64_t> fixedKernels;
+    std::atomic<uint64_t> firstMismatch[OneChangeTelemetry::MISMATCH_BUCKETS];
+    std::atomic<uint64_t> noMismatch;
+    std::atomic<uint64_t> tails;
+    std::atomic<uint64_t> stagedTails;
+    std::atomic<uint64_t> byteLoops;
+};
+
+extern constinit thread_local Counters t_counters;
+
+// Registers t_counters of this thread for the snapshots, at thread exit they move to the totals
+void enroll() noexcept;
+
+} // namespace telemetry
+
+#ifdef ONECHANGE_TELEMETRY
+// the helpers exist only in this build: even an unused instantiation (std::bit_width) can change the kernels' code
+namespace telemetry {
+
+inline void add(std::atomic<uint64_t>& counter) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline void countCall(size_t minSize) noexcept {
+    if (!t_counters.enrolled) [[unlikely]] {
+        enroll();
+    }
+    add(t_counters.calls);
+    if (minSize <= 32) {
+        add(minSize <= 16 ? t_counters.upTo16 : t_counters.upTo32);
+    }
+}
+
+inline void countMismatch(size_t offset) noexcept {
+    constexpr size_t last = OneChangeTelemetry::MISMATCH_BUCKETS - 1;
+    add(t_counters.firstMismatch[std::min<size_t>(std::bit_width(offset), last)]);
+}
+
+inline void countTail(size_t size) noexcept {
+    if (size != 0) {
+        add(t_counters.tails);
+    }
+}
+
+} // namespace telemetry
+
+// a kernel entry, minSize is the size of the shorter string
+#define ONECHANGE_COUNT_CALL(minSize) telemetry::countCall(minSize)
+#define ONECHANGE_COUNT(counter) telemetry::add(telemetry::t_counters.counter)
+#define ONECHANGE_COUNT_MISMATCH(offset) telemetry::countMismatch(offset)
+#define ONECHANGE_COUNT_TAIL(size) telemetry::countTail(size)
+#else
+#define ONECHANGE_COUNT_CALL(minSize) ((void)0)
+#define ONECHANGE_COUNT(counter) ((void)0)
+#define ONECHANGE_COUNT_MISMATCH(offset) ((void)0)
+#define ONECHANGE_COUNT_TAIL(size) ((void)0)
+#endif
@@ -2,13 +2,69 @@
 
 #include <source_location>
 #include <bitset>
+#include <random>
+#include <set>
+#include <thread>
+#include <numeric>
+#include <sys/mman.h>
 
+#include "column.h"
 #include "fn.h"
+#include "index.h"
+#include "join.h"
+#include "matcher.h"
+#include "pairs.h"
+#include "pool.h"
+#include "search.h"
 
 using namespace testing;
 using sv = std::string_view;
 using fn = bool(*)(sv, sv);
 
+constexpr SimdLevel ALL_LEVELS[] = {SimdLevel::Scalar, SimdLevel::SSE, SimdLevel::AVX2, SimdLevel::AVX512};
+
+// oneChangeAuto() at a forced level for the scope: the level before is restored even when an ASSERT_* returns
+class ForcedLevel {
+public:
+    explicit ForcedLevel(SimdLevel level) noexcept
+        : m_saved(oneChangeAutoLevel()) {
+        setOneChangeAutoLevel(level);
+    }
+
+    ~ForcedLevel() {
+        setOneChangeAutoLevel(m_saved);
+    }
+
+    ForcedLevel(ForcedLevel const&) = delete;
+    ForcedLevel& operator=(ForcedLevel const&) = delete;
+
+private:
+    SimdLevel m_saved;
+};
+
+// size symbols from symbol()
+template <typename Symbol>
+std::string randomString(size_t size, Symbol symbol) {
+    std::string str(size, ' ');
+    std::generate(str.begin(), str.end(), symbol);
+    return str;
+}
+
+// count random edits of str (a string or a vector): replace, delete or insert of symbol() at a random position,
+// with transpositions also a swap of neighbours. Edits that need a symbol at the end are skipped.
+template <typename Str, typename Symbol>
+void randomEdits(std::mt19937& engine, Str& str, int count, Symbol symbol, bool transpositions = false) {
+    for (; count != 0; --count) {
+        const auto pos = std::uniform_int_distribution<size_t>(0, str.size())(engine);
+        switch (engine() % (transpositions ? 4 : 3)) {
+            case 0: if (pos != str.size()) str[pos] = symbol(); break;
+            case 1: if (pos != str.size()) str.erase(str.begin() + pos); break;
+            case 3: if (pos + 1 < str.size()) std::swap(str[pos], str[pos + 1]); break;
+            default: str.insert(str.begin() + pos, symbol());
+        }
+    }
+}
+
 class OneChangeTest : public ::testing::TestWithParam<fn> {
 public:
     static constexpr sv prefix15 = "aqzwsxedcrfvrfv";
@@ -22,6 +78,11 @@ public:
 
     void SetUp() override {
         m_pFn = GetParam();
+        for (auto const& kernel : FAST_KERNELS) {
+            if (kernel.fn == m_pFn && detectSimdLevel() < kernel.level) {
+                GTEST_SKIP() << kernel.name << " is not supported";
+            }
+        }
     }
 
     auto tt(std::string_view lhs, std::string_view rhs, std::source_location current = std::source_location::current()) {
@@ -93,12 +154,1017 @@ TEST_P(OneChangeTest, Tests) {
     tf("c" "aaaaaaaaaaaaaaaaaaa", "b" "aaaaaaaaaaaaaaaaaaa" "a");
 }
 
+// base with one or two edits at pos and after it
+static std::vector<std::string> variantsAt(std::string const& base, size_t pos) {
+    const auto size = base.size();
+    std::vector<std::string> variants;
+    if (pos != size) {
+        variants.push_back(base);
+        variants.back()[pos] = '#';
+        variants.push_back(base);
+        variants.back().erase(pos, 1);
+        variants.push_back(variants[0]);
+        variants.back()[size - 1 - (size - 1 - pos) / 2] = '$';
+        variants.push_back(variants[0]);
+        variants.back().erase(size - 1 - (size - 1 - pos) / 3, 1);
+    }
+    variants.push_back(base);
+    variants.back().insert(pos, 1, '#');
+    variants.push_back(variants.back());
+    variants.back().insert(pos / 2, 1, '$');
+    return variants;
+}
+
+TEST_P(OneChangeTest, AllPositions) {
+    const auto fn = GetParam();
+    std::string base;
+    for (size_t size = 0; size != 140; ++size) {
+        for (size_t pos = 0; pos <= size; ++pos) {
+            for (auto const& variant : variantsAt(base, pos)) {
+                EXPECT_EQ(fn(base, variant), oneChangeSlow(base, variant)) << base << " vs " << variant;
+                EXPECT_EQ(fn(variant, base), oneChangeSlow(variant, base)) << variant << " vs " << base;
+            }
+        }
+        base.push_back(static_cast<char>('a' + size % 26));
+    }
+}
+
+// sizes of the grouped long-input scan, the strings start at different offsets from the alignment
+TEST_P(OneChangeTest, LongPositions) {
+    const auto fn = GetParam();
+    for (size_t size : {1023, 1024, 1025, 1057, 1151, 1300, 2100}) {
+        std::string base;
+        for (size_t i = 0; i != size; ++i) {
+            base.push_back(static_cast<char>('a' + i % 26));
+        }
+        for (size_t pos = 0; pos <= size; pos += pos < 40 || size - pos < 300 ? 1 : 13) {
+            for (size_t shift : {0, 1, 7}) {
+                for (auto const& variant : variantsAt(base, pos)) {
+                    const std::string lhs = std::string(shift, ' ') + base;
+                    const std::string rhs = std::string(shift * 2, ' ') + variant;
+                    const sv l = sv(lhs).substr(shift);
+                    const sv r = sv(rhs).substr(shift * 2);
+                    EXPECT_EQ(fn(l, r), oneChangeSlow(l, r)) << size << " " << pos << " " << shift;
+                    EXPECT_EQ(fn(r, l), oneChangeSlow(r, l)) << size << " " << pos << " " << shift;
+                }
+            }
+        }
+    }
+}
+
 INSTANTIATE_TEST_SUITE_P(Slow, OneChangeTest, ::testing::Values(oneChangeSlow));
 INSTANTIATE_TEST_SUITE_P(NoSIMDFast, OneChangeTest, ::testing::Values(oneChangeNoSIMDFast));
 INSTANTIATE_TEST_SUITE_P(Common, OneChangeTest, ::testing::Values(oneChange));
 INSTANTIATE_TEST_SUITE_P(CommonAVX, OneChangeTest, ::testing::Values(oneChangeAVX));
+INSTANTIATE_TEST_SUITE_P(FastSWAR, OneChangeTest, ::testing::Values(oneChangeFastSWAR));
 INSTANTIATE_TEST_SUITE_P(Fast, OneChangeTest, ::testing::Values(oneChangeFast));
 INSTANTIATE_TEST_SUITE_P(FastAVX, OneChangeTest, ::testing::Values(oneChangeFastAVX));
+INSTANTIATE_TEST_SUITE_P(FastAVX512, OneChangeTest, ::testing::Values(oneChangeFastAVX512));
+INSTANTIATE_TEST_SUITE_P(Auto, OneChangeTest, ::testing::Values(oneChangeAuto));
+INSTANTIATE_TEST_SUITE_P(TwoEnded, OneChangeTest, ::testing::Values(oneChangeTwoEnded));
+INSTANTIATE_TEST_SUITE_P(TwoEndedParallel, OneChangeTest, ::testing::Values(oneChangeTwoEndedParallel));
+INSTANTIATE_TEST_SUITE_P(Folded, OneChangeTest,
+                         ::testing::Values(oneChangeFolded<FoldAll<AsciiCaseFold, DashUnderscoreFold>>));
+
+TEST(Dispatch, ForceLowerLevel) {
+    const auto detected = detectSimdLevel();
+    const auto bound = oneChangeAutoLevel();
+    EXPECT_LE(bound, detected);
+
+    for (auto level : ALL_LEVELS) {
+        {
+            const ForcedLevel forcedLevel(level);
+            EXPECT_EQ(oneChangeAutoLevel(), std::min(level, detected)) << toString(level);
+            EXPECT_TRUE(oneChangeAuto("abcd", "abd"));
+            EXPECT_FALSE(oneChangeAuto("abcd", "bad"));
+        }
+        EXPECT_EQ(oneChangeAutoLevel(), bound);
+    }
+}
+
+TEST(CommonAffix, AllLevels) {
+    std::string base;
+    for (size_t i = 0; i != 200; ++i) {
+        base.push_back(static_cast<char>('a' + i % 26));
+    }
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 64, 65, 130, 200}) {
+            const sv lhs = sv(base).substr(0, size);
+            EXPECT_EQ(commonPrefix(lhs, lhs), size);
+            EXPECT_EQ(commonSuffix(lhs, lhs), size);
+            EXPECT_EQ(commonPrefix(lhs, base), size);
+            for (size_t pos = 0; pos < size; ++pos) {
+                std::string rhs(lhs);
+                rhs[pos] = '#';
+                EXPECT_EQ(commonPrefix(lhs, rhs), pos) << toString(forced) << " " << size;
+                EXPECT_EQ(commonSuffix(lhs, rhs), size - 1 - pos) << toString(forced) << " " << size;
+            }
+        }
+    }
+}
+
+TEST(OneChangeTwoEnded, ParallelLong) {
+    std::string base;
+    for (size_t i = 0; i != 100000; ++i) {
+        base.push_back(static_cast<char>('a' + i % 23));
+    }
+
+    for (size_t pos : {0, 1, 4095, 4096, 50000, 95903, 95904, 99998, 99999}) {
+        std::vector<std::string> variants(4, base);
+        variants[0][pos] = '#';
+        variants[1].erase(pos, 1);
+        variants[2].insert(pos, 1, '#');
+        variants[3][pos] = '#';
+        variants[3][(pos + 777) % base.size()] = '$';
+        for (auto const& variant : variants) {
+            EXPECT_EQ(oneChangeTwoEndedParallel(base, variant), oneChangeSlow(base, variant)) << pos;
+            EXPECT_EQ(oneChangeTwoEndedParallel(variant, base), oneChangeSlow(variant, base)) << pos;
+        }
+    }
+}
+
+// Strings end right before a PROT_NONE page: tails must not read past the end at page edges
+TEST(Tails, PageEdge) {
+    constexpr size_t PAGE = 4096;
+    void* mapping = mmap(nullptr, 2 * PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mapping, MAP_FAILED);
+    char* const guard = static_cast<char*>(mapping) + PAGE;
+    ASSERT_EQ(mprotect(guard, PAGE, PROT_NONE), 0);
+
+    std::vector<fn> kernels{oneChangeAuto, oneChangeTwoEnded};
+    for (auto const& kernel : FAST_KERNELS) {
+        if (detectSimdLevel() >= kernel.level) {
+            kernels.push_back(kernel.fn);
+        }
+    }
+    for (size_t size = 0; size != 70; ++size) {
+        // lhs [guard - size, guard), rhs is the one byte longer/shorter/same-size variant right before it
+        std::string base;
+        for (size_t i = 0; i != size; ++i) {
+            base.push_back(static_cast<char>('a' + i % 26));
+        }
+        std::vector<std::string> variants{base, base + "#", base.substr(0, size - (size != 0)), base};
+        if (size != 0) {
+            variants.back().back() = '#';
+        }
+        for (auto const& variant : variants) {
+            char* lhs = guard - size;
+            char* rhs = lhs - 128 - variant.size();
+            memcpy(lhs, base.data(), size);
+            memcpy(rhs, variant.data(), variant.size());
+            const sv lhsView(lhs, size), rhsView(rhs, variant.size());
+            for (auto kernel : kernels) {
+                EXPECT_EQ(kernel(lhsView, rhsView), oneChangeSlow(base, variant)) << base << " vs " << variant;
+                EXPECT_EQ(kernel(rhsView, lhsView), oneChangeSlow(variant, base)) << variant << " vs " << base;
+            }
+            EXPECT_EQ(oneChangeDetail(lhsView, rhsView), oneChangeDetailSlow(base, variant));
+        }
+    }
+
+    munmap(mapping, 2 * PAGE);
+}
+
+TEST(Tails, Padded) {
+    std::string base;
+    for (size_t i = 0; i != 100; ++i) {
+        base.push_back(static_cast<char>('a' + i % 26));
+    }
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size = 0; size != 70; ++size) {
+            for (size_t pos = 0; pos <= size; ++pos) {
+                std::string lhs = base.substr(0, size);
+                std::vector<std::string> variants{lhs, lhs, lhs};
+                variants[0].insert(pos, 1, '#');
+                if (pos != size) {
+                    variants[1][pos] = '#';
+                    variants[2].erase(pos, 1);
+                }
+                for (auto variant : variants) {
+                    const auto expected = oneChangeSlow(lhs, variant);
+                    lhs.reserve(lhs.size() + ONECHANGE_PADDING);
+                    variant.reserve(variant.size() + ONECHANGE_PADDING);
+                    EXPECT_EQ(oneChangePadded(lhs, variant), expected) << lhs << " vs " << variant;
+                    EXPECT_EQ(oneChangePadded(variant, lhs), expected) << variant << " vs " << lhs;
+                }
+            }
+        }
+    }
+}
+
+// UTF-8 reference: split into code points, one edit of the code point sequences
+bool oneChangeUtf8Slow(sv lhs, sv rhs) {
+    const auto split = [](sv str) {
+        std::vector<sv> codePoints;
+        for (size_t i = 0; i != str.size(); ++i) {
+            if ((static_cast<unsigned char>(str[i]) & 0xc0) != 0x80 || codePoints.empty()) {
+                codePoints.emplace_back(str.data() + i, 1);
+            } else {
+                codePoints.back() = sv(codePoints.back().data(), codePoints.back().size() + 1);
+            }
+        }
+        return codePoints;
+    };
+    auto l = split(lhs), r = split(rhs);
+    if (l.size() < r.size()) {
+        std::swap(l, r);
+    }
+    if (l.size() - r.size() > 1) {
+        return false;
+    }
+    const size_t first = std::mismatch(r.begin(), r.end(), l.begin()).first - r.begin();
+    const size_t skip = first + (l.size() == r.size());
+    return first == r.size() || std::equal(l.begin() + first + 1, l.end(), r.begin() + std::min(skip, r.size()));
+}
+
+TEST(OneChangeUtf8, Cases) {
+    EXPECT_TRUE(oneChangeUtf8("", ""));
+    EXPECT_TRUE(oneChangeUtf8("", "\u00e9"));
+    EXPECT_TRUE(oneChangeUtf8("caf\u00e9", "cafe"));
+    EXPECT_TRUE(oneChangeUtf8("caf\u00e9", "caf"));
+    EXPECT_TRUE(oneChangeUtf8("M\u00fcller", "Muller"));
+    EXPECT_TRUE(oneChangeUtf8("M\u00fcller", "M\u00f6ller"));
+    EXPECT_TRUE(oneChangeUtf8("\u0418\u0432\u0430\u043d", "\u0418\u0432\u0430\u043d\u0430"));
+    EXPECT_TRUE(oneChangeUtf8("\u6771\u4eac", "\u6771\U0001f600"));
+    EXPECT_TRUE(oneChangeUtf8("a\u00e9b", "a\u00e8b"));
+    EXPECT_FALSE(oneChangeUtf8("M\u00fcller", "Mueller"));
+    EXPECT_FALSE(oneChangeUtf8("\u00e9\u00e9", "ee"));
+    EXPECT_FALSE(oneChangeUtf8("\u6771\u4eac", ""));
+    // the byte kernel sees a two byte change
+    EXPECT_FALSE(oneChangeFastAVX("M\u00fcller", "M\u00f6ller") && oneChangeFastAVX("caf\u00e9", "caf"));
+}
+
+TEST(OneChangeUtf8, MatchesCodePointSlow) {
+    std::mt19937 engine(7);
+    const std::vector<std::string> alphabet{"a", "b", "\u00e9", "\u00e8", "\u0436", "\u6771", "\u4eac",
+                                            "\U0001f600", "\U0001f601"};
+    std::uniform_int_distribution<size_t> symbol(0, alphabet.size() - 1);
+
+    for (auto forced : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size : {0, 1, 2, 3, 10, 20, 40}) {
+            for (int attempt = 0; attempt != 200; ++attempt) {
+                std::vector<size_t> lhs(size);
+                for (auto& cp : lhs) {
+                    cp = symbol(engine);
+                }
+                auto rhs = lhs;
+                randomEdits(engine, rhs, attempt % 3, [&] { return symbol(engine); });
+                std::string l, r;
+                for (auto cp : lhs) l += alphabet[cp];
+                for (auto cp : rhs) r += alphabet[cp];
+
+                EXPECT_EQ(oneChangeUtf8(l, r), oneChangeUtf8Slow(l, r)) << l << " vs " << r;
+                EXPECT_EQ(oneChangeUtf8(r, l), oneChangeUtf8Slow(r, l)) << r << " vs " << l;
+            }
+        }
+    }
+}
+
+TEST(OneChangeFolded, Cases) {
+    EXPECT_TRUE(oneChangeFolded<AsciiCaseFold>("Hello-World", "hELLO-wORLD"));
+    EXPECT_TRUE(oneChangeFolded<AsciiCaseFold>("Hello-World", "hello_world"));
+    EXPECT_FALSE(oneChangeFolded<AsciiCaseFold>("Hello-World", "hello_world!"));
+    EXPECT_FALSE(oneChangeFolded<AsciiCaseFold>("@[`{", "`{@["));
+    EXPECT_TRUE(oneChangeFolded<DashUnderscoreFold>("snake_case_name", "snake-case-names"));
+    EXPECT_FALSE(oneChangeFolded<DashUnderscoreFold>("snake_case_name", "Snake-case-names"));
+    using Fold = FoldAll<AsciiCaseFold, DashUnderscoreFold>;
+    EXPECT_TRUE(oneChangeFolded<Fold>("Snake_Case_Name", "snake-case-names"));
+    // bytes >= 0x80 are never folded
+    EXPECT_FALSE(oneChangeFolded<AsciiCaseFold>("\xc1\xc1", "\xe1\xe1"));
+}
+
+TEST(OneChangeFolded, MatchesSlowOnFolded) {
+    std::mt19937 engine(11);
+    constexpr sv alphabet = "aAzZbB-_@[`{\x80\xc1\xe1";
+    std::uniform_int_distribution<size_t> symbol(0, alphabet.size() - 1);
+    const auto fold = [](std::string str) {
+        for (auto& c : str) {
+            c = c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c == '_' ? '-' : c;
+        }
+        return str;
+    };
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size = 0; size != 70; ++size) {
+            for (int attempt = 0; attempt != 20; ++attempt) {
+                std::string lhs(size, ' ');
+                for (auto& c : lhs) {
+                    c = alphabet[symbol(engine)];
+                }
+                // same text in another case/separator spelling plus 0..2 edits
+                std::string rhs = lhs;
+                for (auto& c : rhs) {
+                    c = engine() % 2 ? c : fold(std::string(1, c))[0];
+                }
+                randomEdits(engine, rhs, attempt % 3, [&] { return alphabet[symbol(engine)]; });
+
+                using Fold = FoldAll<AsciiCaseFold, DashUnderscoreFold>;
+                const auto expected = oneChangeSlow(fold(lhs), fold(rhs));
+                EXPECT_EQ(oneChangeFolded<Fold>(lhs, rhs), expected) << lhs << " vs " << rhs;
+                EXPECT_EQ(oneChangeFolded<Fold>(rhs, lhs), expected) << rhs << " vs " << lhs;
+            }
+        }
+    }
+}
+
+TEST(OneChangeWide, Cases) {
+    EXPECT_TRUE(oneChangeWide(u"\u041f\u0440\u0438\u0432\u0435\u0442", u"\u041f\u0440\u0438\u0432\u0435\u0442!"));
+    EXPECT_TRUE(oneChangeWide(u"\U0001f600 smile", u"\U0001f601 smile")); // one surrogate unit differs
+    EXPECT_FALSE(oneChangeWide(u"\U0001f600 smile", u" smile")); // a surrogate pair is two units
+    EXPECT_TRUE(oneChangeWide(U"\U0001f600 smile", U" smile"));
+    // 0x0100 vs 0x0001: equal low bytes must not hide the element error
+    EXPECT_FALSE(oneChangeWide(std::u16string(20, 0x0100), std::u16string(20, 0x0001)));
+
+    const std::vector<uint32_t> query{101, 7, 2024, 9, 55};
+    EXPECT_TRUE(oneChangeWide(query, std::vector<uint32_t>{101, 7, 9, 55}));
+    EXPECT_EQ(oneChangeDetailWide(query, std::vector<uint32_t>{101, 7, 9, 55}),
+              (OneChangeResult{OneChangeKind::Delete, 2}));
+    EXPECT_EQ(oneChangeDetailWide(query, std::vector<uint32_t>{101, 7, 2024, 9, 55, 1}),
+              (OneChangeResult{OneChangeKind::Insert, 5}));
+    EXPECT_FALSE(oneChangeWide(query, std::vector<uint32_t>{7, 101, 2024, 9, 55}));
+}
+
+template <typename T>
+void testWideMatchesSlow() {
+    std::mt19937 engine(13);
+    std::uniform_int_distribution<uint32_t> symbol(0, 3);
+    // two symbols differ only in the high byte, one only in the low byte
+    const auto element = [&]() { return static_cast<T>(std::array<uint32_t, 4>{1, 0x0101, 0x10001, 0x0100}[symbol(engine)]); };
+
+    // all tails, then long-input mode (from 1024 bytes on)
+    std::vector<size_t> sizes(80);
+    std::iota(sizes.begin(), sizes.end(), 0);
+    sizes.insert(sizes.end(), {256, 300, 520, 1000, 2100});
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size : sizes) {
+            for (int attempt = 0; attempt != 20; ++attempt) {
+                std::vector<T> lhs(size);
+                std::generate(lhs.begin(), lhs.end(), element);
+                auto rhs = lhs;
+                randomEdits(engine, rhs, attempt % 3, element);
+
+                // the byte reference sees each element as one char: 4 symbols map to 'a'..'d'
+                const auto narrow = [](std::vector<T> const& str) {
+                    std::string result;
+                    for (auto c : str) {
+                        result.push_back(c == 1 ? 'a' : c == 0x0101 ? 'b' : c == static_cast<T>(0x10001) ? 'c' : 'd');
+                    }
+                    return result;
+                };
+                const auto expected = oneChangeDetailSlow(narrow(lhs), narrow(rhs));
+                EXPECT_EQ(oneChangeDetailWide(lhs, rhs), expected) << size << " " << attempt;
+                EXPECT_EQ(oneChangeWide(rhs, lhs), expected.kind != OneChangeKind::None) << size << " " << attempt;
+            }
+        }
+    }
+}
+
+TEST(OneChangeWide, MatchesSlow16) {
+    testWideMatchesSlow<uint16_t>();
+}
+
+TEST(OneChangeWide, MatchesSlow32) {
+    testWideMatchesSlow<uint32_t>();
+}
+
+// lhs of N bytes vs rhs of M bytes with 0..2 random edits over a 2-symbol alphabet (shifted matches are common)
+template <size_t N, size_t M>
+void testFixedMatchesSlow(std::mt19937& engine) {
+    for (int attempt = 0; attempt != 200; ++attempt) {
+        std::string lhs(N, 'a');
+        for (auto& c : lhs) {
+            c = engine() % 2 ? 'a' : 'b';
+        }
+        std::string rhs = lhs;
+        if (M < N) {
+            rhs.erase(engine() % N, 1);
+        } else if (M > N) {
+            rhs.insert(engine() % (N + 1), 1, engine() % 2 ? 'a' : 'b');
+        }
+        for (int edits = attempt % 3; edits != 0; --edits) {
+            rhs[engine() % M] = engine() % 2 ? 'a' : 'b';
+        }
+
+        const auto expected = oneChangeSlow(lhs, rhs);
+        EXPECT_EQ((oneChangeFixed<N, M>(lhs.data(), rhs.data())), expected) << N << " " << lhs << " vs " << rhs;
+        EXPECT_EQ((oneChangeFixed<M, N>(rhs.data(), lhs.data())), expected) << N << " " << rhs << " vs " << lhs;
+        EXPECT_EQ(oneChangeAuto(lhs, rhs), expected) << N << " " << lhs << " vs " << rhs;
+    }
+}
+
+template <size_t N>
+void testFixedMatchesSlow(std::mt19937& engine) {
+    testFixedMatchesSlow<N, N - 1>(engine);
+    testFixedMatchesSlow<N, N>(engine);
+    testFixedMatchesSlow<N, N + 1>(engine);
+}
+
+static_assert(oneChangeFixed<4>("abcd", "abxd"));
+static_assert(!oneChangeFixed<4>("abcd", "axyd"));
+static_assert(oneChangeFixed<4, 3>("abcd", "acd"));
+static_assert(oneChangeFixed<3, 4>("abd", "abcd"));
+static_assert(!oneChangeFixed<4, 3>("abcd", "bad"));
+
+TEST(OneChangeFixed, MatchesSlow) {
+    std::mt19937 engine(17);
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        testFixedMatchesSlow<16>(engine);
+        testFixedMatchesSlow<32>(engine);
+        testFixedMatchesSlow<64>(engine);
+        testFixedMatchesSlow<20>(engine); // not specialized: oneChangeAuto()
+    }
+}
+
+std::string applyChange(std::string_view lhs, std::string_view rhs, OneChangeResult change) {
+    std::string result(lhs);
+    switch (change.kind) {
+        case OneChangeKind::Replace: result[change.offset] = rhs[change.offset]; break;
+        case OneChangeKind::Insert: result.insert(change.offset, 1, rhs[change.offset]); break;
+        case OneChangeKind::Delete: result.erase(change.offset, 1); break;
+        case OneChangeKind::Transpose: std::swap(result[change.offset], result[change.offset + 1]); break;
+        default: break;
+    }
+    return result;
+}
+
+TEST(OneChangeDetail, Kinds) {
+    EXPECT_EQ(oneChangeDetail("abc", "abc"), (OneChangeResult{OneChangeKind::Equal, 0}));
+    EXPECT_EQ(oneChangeDetail("abc", "abd"), (OneChangeResult{OneChangeKind::Replace, 2}));
+    EXPECT_EQ(oneChangeDetail("abc", "xabc"), (OneChangeResult{OneChangeKind::Insert, 0}));
+    EXPECT_EQ(oneChangeDetail("abc", "ac"), (OneChangeResult{OneChangeKind::Delete, 1}));
+    EXPECT_EQ(oneChangeDetail("aab", "ab"), (OneChangeResult{OneChangeKind::Delete, 1}));
+    EXPECT_EQ(oneChangeDetail("abc", "cba"), (OneChangeResult{OneChangeKind::None, 0}));
+    EXPECT_EQ(oneChangeDetail("a", "abc"), (OneChangeResult{OneChangeKind::None, 0}));
+}
+
+TEST(OneChangeDetail, MatchesSlow) {
+    std::string base;
+    for (size_t size = 0; size != 100; ++size) {
+        for (size_t pos = 0; pos != size; ++pos) {
+            std::vector<std::string> variants{base, base, base, base};
+            variants[0][pos] = '#';
+            variants[1].erase(pos, 1);
+            variants[2].insert(pos, 1, '#');
+            variants[3][pos] = '#';
+            variants[3][size - 1 - (size - 1 - pos) / 2] = '$';
+
+            for (auto forced : ALL_LEVELS) {
+                const ForcedLevel forcedLevel(forced);
+                for (auto const& variant : variants) {
+                    for (auto [lhs, rhs] : {std::pair<sv, sv>{base, variant}, std::pair<sv, sv>{variant, base}}) {
+                        const auto result = oneChangeDetail(lhs, rhs);
+                        EXPECT_EQ(result, oneChangeDetailSlow(lhs, rhs)) << lhs << " vs " << rhs;
+                        EXPECT_EQ(result.kind != OneChangeKind::None, oneChangeSlow(lhs, rhs));
+                        if (result.kind != OneChangeKind::None) {
+                            EXPECT_EQ(applyChange(lhs, rhs, result), rhs);
+                        }
+                    }
+                }
+            }
+        }
+        base.push_back(static_cast<char>('a' + size % 26));
+    }
+}
+
+TEST(OneChangeOps, Cases) {
+    EXPECT_TRUE(oneChangeOrTranspose("the", "teh"));
+    EXPECT_TRUE(oneChangeOrTranspose("the", "then"));
+    EXPECT_FALSE(oneChangeOrTranspose("the", "eht"));
+    EXPECT_FALSE(oneChangeOrTranspose("abcd", "badc"));
+    EXPECT_FALSE(oneChangeOrTranspose("aab", "bba")); // two errors, not crossed
+    EXPECT_EQ(oneChangeDetailOrTranspose("receive", "recieve"), (OneChangeResult{OneChangeKind::Transpose, 3}));
+    EXPECT_EQ(oneChangeDetailOrTranspose("receive", "recive"), (OneChangeResult{OneChangeKind::Delete, 3}));
+
+    EXPECT_TRUE(oneChangeOps<HammingEdits>("abc", "abd"));
+    EXPECT_FALSE(oneChangeOps<HammingEdits>("abc", "ab"));
+    EXPECT_FALSE(oneChangeOps<IndelEdits>("abc", "abd"));
+    EXPECT_TRUE(oneChangeOps<IndelEdits>("abc", "ab"));
+    EXPECT_TRUE(oneChangeOps<IndelEdits>("abc", "abc"));
+    EXPECT_FALSE(oneChangeOps<LevenshteinEdits>("abc", "acb"));
+}
+
+TEST(OneChangeOps, MatchesSlow) {
+    std::mt19937 engine(19);
+    const auto symbol = [&engine]() { return static_cast<char>('a' + engine() % 3); };
+    const auto transposed = [](sv lhs, sv rhs) {
+        for (size_t i = 0; i + 1 < lhs.size() && lhs.size() == rhs.size(); ++i) {
+            std::string swapped(lhs);
+            std::swap(swapped[i], swapped[i + 1]);
+            if (swapped == rhs) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size = 0; size != 140; ++size) {
+            for (int attempt = 0; attempt != 12; ++attempt) {
+                std::string lhs = randomString(size, symbol);
+                std::string rhs = lhs;
+                randomEdits(engine, rhs, attempt % 3, symbol, true);
+
+                const bool levenshtein = oneChangeSlow(lhs, rhs);
+                const bool sameSize = lhs.size() == rhs.size();
+                EXPECT_EQ(oneChangeOps<HammingEdits>(lhs, rhs), levenshtein && sameSize) << lhs << " vs " << rhs;
+                EXPECT_EQ(oneChangeOps<IndelEdits>(lhs, rhs), levenshtein && (!sameSize || lhs == rhs))
+                        << lhs << " vs " << rhs;
+                EXPECT_EQ(oneChangeOps<LevenshteinEdits>(lhs, rhs), levenshtein) << lhs << " vs " << rhs;
+                EXPECT_EQ(oneChangeOrTranspose(lhs, rhs), levenshtein || transposed(lhs, rhs)) << lhs << " vs " << rhs;
+
+                const auto result = oneChangeDetailOrTranspose(lhs, rhs);
+                EXPECT_EQ(result.kind != OneChangeKind::None, levenshtein || transposed(lhs, rhs));
+                if (result.kind != OneChangeKind::None) {
+                    EXPECT_EQ(applyChange(lhs, rhs, result), rhs) << lhs << " vs " << rhs;
+                }
+            }
+        }
+    }
+}
+
+TEST(OneChangeTelemetry, Snapshot) {
+    resetOneChangeTelemetry();
+    const std::string key(40, 'k');
+    std::string replaced = key;
+    replaced[33] = 'x';
+    EXPECT_TRUE(oneChangeAuto(key, key));
+    EXPECT_TRUE(oneChangeAuto(key, replaced));
+    EXPECT_FALSE(oneChangeAuto(key, key.substr(2)));
+    std::thread([&key] { EXPECT_TRUE(oneChangeAuto(key.substr(0, 8), key.substr(0, 9))); }).join();
+
+    const auto telemetry = oneChangeTelemetry();
+    if (!oneChangeTelemetryEnabled()) {
+        EXPECT_EQ(telemetry.calls, 0u);
+        EXPECT_EQ(toJson(telemetry).find("\"calls\": 0"), 1u);
+        return;
+    }
+    EXPECT_EQ(telemetry.calls, 4u);
+    EXPECT_EQ(telemetry.sameSize, 2u);
+    EXPECT_EQ(telemetry.diffSize, 1u);
+    EXPECT_EQ(telemetry.lengthRejects, 1u);
+    EXPECT_EQ(telemetry.upTo16, 1u); // the exited thread is merged
+    EXPECT_EQ(telemetry.noMismatch, 1u);
+    EXPECT_EQ(telemetry.firstMismatch[6], 1u); // 33 in [32, 64)
+    EXPECT_EQ(telemetry.firstMismatch[4], 1u); // the extra byte at 8
+
+    resetOneChangeTelemetry();
+    EXPECT_EQ(oneChangeTelemetry().calls, 0u);
+}
+
+TEST(OneChangeBatch, MatchesSlow) {
+    // distinct neighbours, then runs of three: an extra symbol in a run can be at several positions
+    for (size_t run : {1, 3}) {
+        std::string query;
+        for (size_t size = 0; size != 140; ++size) {
+            std::vector<std::string> storage{query, query + "a", query + "b", "a" + query, query + "ab"};
+            for (size_t pos = 0; pos < size; pos += 3) {
+                storage.push_back(query);
+                storage.back()[pos] = '#';
+                storage.push_back(query);
+                storage.back().erase(pos, 1);
+                storage.push_back(query);
+                storage.back().insert(pos, 1, '#');
+                storage.push_back(storage.back());
+                storage.back()[size / 2] = '$';
+                storage.push_back(query);
+                storage.back().insert(pos, 1, query[pos]);
+                storage.push_back(storage.back());
+                storage.back()[size / 2] = '$';
+            }
+            std::vector<sv> candidates(storage.begin(), storage.end());
+
+            for (auto forced : ALL_LEVELS) {
+                const ForcedLevel forcedLevel(forced);
+                std::vector<uint64_t> out((candidates.size() + 63) / 64, ~0ull);
+                size_t expectedCount = 0;
+                const auto count = oneChangeBatch(query, candidates, out);
+                for (size_t i = 0; i != candidates.size(); ++i) {
+                    const bool expected = oneChangeSlow(query, candidates[i]);
+                    expectedCount += expected;
+                    EXPECT_EQ((out[i / 64] >> (i % 64)) & 1, expected)
+                        << query << " vs " << candidates[i] << " " << toString(oneChangeAutoLevel());
+                }
+                EXPECT_EQ(count, expectedCount);
+            }
+            query.push_back(static_cast<char>('a' + size / run % 26));
+        }
+    }
+}
+
+TEST(OneChangeShortBatch, MatchesSlow) {
+    constexpr size_t PAGE = 4096;
+    void* mapping = mmap(nullptr, 2 * PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mapping, MAP_FAILED);
+    char* const guard = static_cast<char*>(mapping) + PAGE;
+    ASSERT_EQ(mprotect(guard, PAGE, PROT_NONE), 0);
+
+    std::mt19937 engine(21);
+    const auto symbol = [&engine]() { return static_cast<char>('a' + engine() % 3); };
+    std::vector<std::string> storage;
+    for (int i = 0; i != 1000; ++i) {
+        std::string lhs = randomString(engine() % (ONECHANGE_SHORT_BATCH_SIZE + 4), symbol);
+        std::string rhs = lhs;
+        randomEdits(engine, rhs, i % 3, symbol);
+        storage.push_back(std::move(lhs));
+        storage.push_back(std::move(rhs));
+    }
+    std::vector<sv> lhs;
+    std::vector<sv> rhs;
+    for (size_t i = 0; i != storage.size(); i += 2) {
+        lhs.emplace_back(storage[i]);
+        rhs.emplace_back(storage[i + 1]);
+    }
+    // empty views without data
+    lhs.insert(lhs.end(), {sv(), sv(), sv("a")});
+    rhs.insert(rhs.end(), {sv(), sv("a"), sv()});
+    // short strings that end right before a PROT_NONE page
+    for (size_t size = 0; size <= ONECHANGE_SHORT_BATCH_SIZE; ++size) {
+        char* edge = guard - size;
+        memcpy(edge, "abcdefghijklmnopq", size);
+        lhs.emplace_back(edge, size);
+        rhs.emplace_back("abcdefghijklmnopq", size - (size != 0));
+    }
+
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size : {lhs.size(), size_t{0}, size_t{1}, size_t{33}}) {
+            std::vector<uint32_t> out((size + 31) / 32, ~0u);
+            size_t expectedCount = 0;
+            const auto count = oneChangeShortBatch({lhs.data(), size}, {rhs.data(), size}, out);
+            for (size_t i = 0; i != size; ++i) {
+                const bool expected = oneChangeSlow(lhs[i], rhs[i]);
+                expectedCount += expected;
+                EXPECT_EQ((out[i / 32] >> (i % 32)) & 1, expected)
+                    << lhs[i] << " vs " << rhs[i] << " " << toString(oneChangeAutoLevel());
+            }
+            EXPECT_EQ(count, expectedCount);
+        }
+    }
+    munmap(mapping, 2 * PAGE);
+}
+
+TEST(StringColumn, MatchesSlow) {
+    constexpr size_t PAGE = 4096;
+    std::mt19937 engine(22);
+    const auto symbol = [&engine]() { return static_cast<char>('a' + engine() % 3); };
+    StringColumnBuilder lhsBuilder;
+    StringColumnBuilder rhsBuilder;
+    std::string query = "abcabcabcabcabcabcabcabcabcabcabcabcab";
+    for (int i = 0; i != 1000; ++i) {
+        std::string lhs = randomString(engine() % 80, symbol);
+        std::string rhs = i % 4 == 0 ? query : lhs;
+        randomEdits(engine, rhs, i % 3, symbol);
+        lhsBuilder.append(lhs);
+        rhsBuilder.append(rhs);
+    }
+    const auto padded = lhsBuilder.column();
+    const auto rhs = rhsBuilder.column();
+
+    // the same rows without padding: the data ends right before a PROT_NONE page
+    std::vector<StringColumn::offset_t> offsets;
+    std::string data;
+    for (size_t i = 0; i != padded.size(); ++i) {
+        offsets.push_back(static_cast<StringColumn::offset_t>(data.size()));
+        data.append(padded[i]);
+    }
+    offsets.push_back(static_cast<StringColumn::offset_t>(data.size()));
+    const size_t pages = data.size() / PAGE + 2;
+    void* mapping = mmap(nullptr, pages * PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mapping, MAP_FAILED);
+    char* const guard = static_cast<char*>(mapping) + (pages - 1) * PAGE;
+    ASSERT_EQ(mprotect(guard, PAGE, PROT_NONE), 0);
+    memcpy(guard - data.size(), data.data(), data.size());
+    const StringColumn unpadded(offsets, {guard - data.size(), data.size()});
+    EXPECT_TRUE(padded.padded());
+    EXPECT_FALSE(unpadded.padded());
+    // slices: offsets don't start at 0
+    const std::span<const StringColumn::offset_t> allOffsets(offsets);
+    const StringColumn slice(allOffsets.subspan(100, 201), {guard - data.size(), data.size()});
+    const StringColumn nextSlice(allOffsets.subspan(101, 201), {guard - data.size(), data.size()});
+
+    const auto check = [](auto const& lhsAt, auto const& rhsAt, size_t size, std::span<const uint64_t> out,
+                          size_t count) {
+        size_t expectedCount = 0;
+        for (size_t i = 0; i != size; ++i) {
+            const bool expected = oneChangeSlow(lhsAt(i), rhsAt(i));
+            expectedCount += expected;
+            EXPECT_EQ((out[i / 64] >> (i % 64)) & 1, expected)
+                << lhsAt(i) << " vs " << rhsAt(i) << " " << toString(oneChangeAutoLevel());
+        }
+        EXPECT_EQ(count, expectedCount);
+    };
+    for (auto forced : ALL_LEVELS) {
+        const ForcedLevel forcedLevel(forced);
+        std::vector<uint64_t> out((padded.size() + 63) / 64, ~0ull);
+        for (auto const* lhs : {&padded, &unpadded}) {
+            const auto lhsAt = [lhs](size_t i) { return (*lhs)[i]; };
+            const auto rhsAt = [&rhs](size_t i) { return rhs[i]; };
+            check(lhsAt, rhsAt, rhs.size(), out, oneChangeColumn(*lhs, rhs, out));
+            const auto queryAt = [&query](size_t) { return sv(query); };
+            check(lhsAt, queryAt, lhs->size(), out, oneChangeColumn(*lhs, query, out));
+        }
+        check([&padded](size_t i) { return padded[i + 100]; }, [&padded](size_t i) { return padded[i + 101]; },
+              slice.size(), out, oneChangeColumn(slice, nextSlice, out));
+    }
+    munmap(mapping, pages * PAGE);
+}
+
+TEST(OneChangeMatcher, MatchesSlow) {
+    std::mt19937 engine(24);
+    const auto symbol = [&engine]() { return static_cast<char>('a' + engine() % 3); };
+    for (int i = 0; i != 3000; ++i) {
+        std::string lhs = randomString(engine() % 300, symbol);
+        std::string rhs = lhs;
+        randomEdits(engine, rhs, i % 3, symbol);
+        const bool expected = oneChangeSlow(lhs, rhs);
+
+        // chunks of random size in random order, the sizes declared for every second pair
+        auto matcher = i % 2 == 0 ? OneChangeMatcher(lhs.size(), rhs.size()) : OneChangeMatcher();
+        const size_t maxChunk = 1 + engine() % 40;
+        size_t lhsFed = 0;
+        size_t rhsFed = 0;
+        while (lhsFed != lhs.size() || rhsFed != rhs.size()) {
+            const bool toLhs = rhsFed == rhs.size() || (lhsFed != lhs.size() && engine() % 2 == 0);
+            auto& fed = toLhs ? lhsFed : rhsFed;
+            auto const& str = toLhs ? lhs : rhs;
+            const auto chunk = sv(str).substr(fed, 1 + engine() % maxChunk);
+            fed += chunk.size();
+            const bool possible = toLhs ? matcher.feedLhs(chunk) : matcher.feedRhs(chunk);
+            EXPECT_TRUE(possible || !expected) << lhs << " vs " << rhs;
+            const auto skew = std::max(lhsFed, rhsFed) - std::min(lhsFed, rhsFed);
+            EXPECT_LE(matcher.buffered(), 2 * skew + 4) << lhs << " vs " << rhs;
+        }
+        EXPECT_EQ(matcher.finish(), expected) << lhs << " vs " << rhs;
+    }
+
+    EXPECT_FALSE(OneChangeMatcher(5, 7).possible());
+    EXPECT_TRUE(OneChangeMatcher().finish());
+}
+
+TEST(OneChangeMatcher, LongStreams) {
+    std::string lhs;
+    for (size_t i = 0; i != 1 << 20; ++i) {
+        lhs.push_back(static_cast<char>('a' + i % 23));
+    }
+    for (size_t pos : {0, 4095, 500000, (1 << 20) - 1}) {
+        std::string rhs = lhs;
+        rhs.erase(pos, 1);
+        OneChangeMatcher matcher;
+        for (size_t i = 0; i < lhs.size(); i += 4096) {
+            matcher.feedLhs(sv(lhs).substr(i, 4096));
+            matcher.feedRhs(sv(rhs).substr(i, 4096));
+            EXPECT_LE(matcher.buffered(), 2 * 4096 + 4);
+        }
+        EXPECT_TRUE(matcher.finish()) << pos;
+
+        rhs[pos / 2] = '#';
+        OneChangeMatcher rejecting;
+        size_t fed = 0;
+        while (fed < rhs.size() && rejecting.feedLhs(sv(lhs).substr(fed, 4096))
+               && rejecting.feedRhs(sv(rhs).substr(fed, 4096))) {
+            fed += 4096;
+        }
+        // rejected within a chunk of the second error
+        EXPECT_LE(fed, pos + 4096) << pos;
+        EXPECT_FALSE(rejecting.finish());
+    }
+}
+
+TEST(FindOneEdit, MatchesBruteForce) {
+    std::mt19937 engine(25);
+    for (int i = 0; i != 300; ++i) {
+        // small alphabets give dense hits, the pattern is planted with edits
+        const char symbols = static_cast<char>(i % 3 == 0 ? 2 : i % 3 == 1 ? 4 : 26);
+        const auto symbol = [&] { return static_cast<char>('a' + engine() % symbols); };
+        std::string text = randomString(engine() % 400, symbol);
+        const std::string pattern = randomString(engine() % 40, symbol);
+        for (int plant = 0; plant != 3 && !text.empty(); ++plant) {
+            std::string copy = pattern;
+            if (!copy.empty() && plant != 0) {
+                const auto pos = engine() % copy.size();
+                plant == 1 ? (void)copy.erase(pos, 1) : (void)copy.insert(pos, 1, '#');
+            }
+            text.replace(engine() % text.size(), 0, copy);
+        }
+
+        std::vector<std::pair<size_t, size_t>> expected;
+        for (size_t pos = 0; pos <= text.size(); ++pos) {
+            for (size_t size = pattern.empty() ? 0 : pattern.size() - 1; size <= pattern.size() + 1; ++size) {
+                if (pos + size <= text.size() && oneChangeSlow(sv(text).substr(pos, size), pattern)) {
+                    expected.emplace_back(pos, size);
+                }
+            }
+        }
+        for (auto forced : ALL_LEVELS) {
+            const ForcedLevel forcedLevel(forced);
+            std::vector<std::pair<size_t, size_t>> found;
+            findOneEdit(text, pattern, [&](size_t pos, size_t size) { found.emplace_back(pos, size); });
+            EXPECT_EQ(found, expected) << text << " / " << pattern << " " << toString(oneChangeAutoLevel());
+        }
+    }
+}
+
+TEST(OneEditIndex, MatchesBruteForce) {
+    std::mt19937 engine(7);
+    std::uniform_int_distribution<> symbol('a', 'd');
+    std::uniform_int_distribution<size_t> size(0, 7);
+    std::vector<std::string> words;
+    for (int i = 0; i != 2000; ++i) {
+        std::string word;
+        for (auto n = size(engine); n != 0; --n) {
+            word.push_back(static_cast<char>(symbol(engine)));
+        }
+        words.push_back(word);
+    }
+    words.push_back(std::string(70, 'x'));
+    words.push_back(std::string(70, 'x') + "y");
+
+    const std::vector<sv> entries(words.begin(), words.end());
+    const OneEditIndex index(entries);
+    ASSERT_EQ(index.size(), entries.size());
+
+    std::vector<std::string> keys(words.begin(), words.begin() + 300);
+    keys.push_back(std::string(69, 'x') + "y");
+    keys.push_back("");
+    keys.push_back("abcdabcd");
+    for (auto const& key : keys) {
+        std::vector<OneEditIndex::id_t> expected;
+        for (OneEditIndex::id_t id = 0; id != entries.size(); ++id) {
+            EXPECT_EQ(index[id], entries[id]);
+            if (oneChangeSlow(key, entries[id])) {
+                expected.push_back(id);
+            }
+        }
+        EXPECT_EQ(index.query(key), expected) << key;
+    }
+}
+
+TEST(OneEditSelfJoin, MatchesBruteForce) {
+    std::mt19937 engine(11);
+    std::uniform_int_distribution<> symbol('a', 'c');
+    std::uniform_int_distribution<size_t> size(0, 9);
+    std::vector<std::string> storage;
+    for (int i = 0; i != 3000; ++i) {
+        std::string str;
+        for (auto n = size(engine); n != 0; --n) {
+            str.push_back(static_cast<char>(symbol(engine)));
+        }
+        storage.push_back(str);
+    }
+    storage.push_back(storage[5]);
+    const std::vector<sv> strings(storage.begin(), storage.end());
+
+    std::set<std::pair<size_t, size_t>> expected;
+    for (size_t i = 0; i != strings.size(); ++i) {
+        for (size_t j = i + 1; j != strings.size(); ++j) {
+            if (oneChangeSlow(strings[i], strings[j])) {
+                expected.emplace(i, j);
+            }
+        }
+    }
+
+    for (unsigned threads : {1, 4}) {
+        std::mutex mutex;
+        std::vector<std::pair<size_t, size_t>> pairs;
+        WorkStealingPool pool(threads);
+        oneEditSelfJoin(strings, [&](size_t lhs, size_t rhs) {
+            std::lock_guard lock(mutex);
+            pairs.emplace_back(lhs, rhs);
+        }, pool);
+
+        EXPECT_EQ(pairs.size(), expected.size()) << "duplicates or misses with " << threads << " threads";
+        EXPECT_EQ(std::set(pairs.begin(), pairs.end()), expected);
+    }
+}
+
+// output of checkPairs() into a string
+std::string checkPairsOutput(sv input, PairOutput mode, WorkStealingPool& pool, size_t chunkSize, PairStats& stats) {
+    FILE* out = tmpfile();
+    stats = checkPairs(input, mode, out, pool, chunkSize);
+    std::string result(static_cast<size_t>(ftell(out)), '\0');
+    rewind(out);
+    EXPECT_EQ(fread(result.data(), 1, result.size(), out), result.size());
+    fclose(out);
+    return result;
+}
+
+TEST(CheckPairs, RoundTripAcrossChunks) {
+    std::mt19937 engine(8);
+    std::uniform_int_distribution<> symbol('a', 'c');
+    std::string input;
+    std::vector<std::string> lines;
+    for (int i = 0; i != 1000; ++i) {
+        std::string lhs = randomString(engine() % 12, [&]() { return static_cast<char>(symbol(engine)); });
+        std::string rhs = lhs;
+        if (i % 2 == 0 && !rhs.empty()) {
+            rhs.erase(engine() % rhs.size(), 1);
+        }
+        if (i % 5 == 0) {
+            rhs += "xy";
+        }
+        lines.push_back(i % 97 == 0 ? lhs : lhs + "\t" + rhs);
+        input += lines.back() + (i % 7 == 0 ? "\r\n" : "\n");
+    }
+    lines.push_back(std::string(300, 'a') + "\t" + std::string(299, 'a')); // longer than a chunk
+    input += lines.back() + "\n";
+    lines.push_back("ab\tb"); // no newline at the end
+    input += lines.back();
+
+    std::string bitmap((lines.size() + 7) / 8, '\0');
+    std::string matches;
+    std::string rejects;
+    size_t expectedMatches = 0;
+    for (size_t i = 0; i != lines.size(); ++i) {
+        const auto tab = lines[i].find('\t');
+        const bool match = tab != std::string::npos && oneChangeSlow(sv(lines[i]).substr(0, tab),
+                                                                     sv(lines[i]).substr(tab + 1));
+        expectedMatches += match;
+        bitmap[i / 8] = static_cast<char>(bitmap[i / 8] | match << (i % 8));
+        // lines are written as is, \r included
+        (match ? matches : rejects) += lines[i] + (i % 7 == 0 && i < 1000 ? "\r" : "") + "\n";
+    }
+
+    for (size_t chunkSize : {size_t{1}, size_t{100}, size_t{4096}, PAIR_CHUNK_SIZE}) {
+        const auto chunks = splitPairChunks(input, chunkSize);
+        std::string joined;
+        for (auto chunk : chunks) {
+            EXPECT_TRUE(chunk.ends_with('\n') || chunk.data() + chunk.size() == input.data() + input.size());
+            joined += chunk;
+        }
+        EXPECT_EQ(joined, input);
+        EXPECT_EQ(chunks.size() > 1, chunkSize < input.size());
+
+        for (unsigned threads : {1, 3}) {
+            WorkStealingPool pool(threads);
+            PairStats stats;
+            EXPECT_EQ(checkPairsOutput(input, PairOutput::Bitmap, pool, chunkSize, stats), bitmap) << chunkSize;
+            EXPECT_EQ(stats.pairs, lines.size());
+            EXPECT_EQ(stats.matches, expectedMatches);
+            EXPECT_EQ(stats.malformed, 11u);
+            EXPECT_EQ(checkPairsOutput(input, PairOutput::Matches, pool, chunkSize, stats), matches) << chunkSize;
+            EXPECT_EQ(checkPairsOutput(input, PairOutput::Rejects, pool, chunkSize, stats), rejects) << chunkSize;
+            EXPECT_EQ(checkPairsOutput(input, PairOutput::None, pool, chunkSize, stats), "");
+        }
+    }
+}
+
+TEST(EditDistance, WithinMatchesSlow) {
+    std::mt19937 engine(42);
+    const auto symbol = [&engine]() { return static_cast<char>('a' + engine() % 3); };
+
+    for (auto forced : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        const ForcedLevel forcedLevel(forced);
+        for (size_t size : {0, 1, 2, 5, 17, 40, 63, 64, 65, 66, 100, 150}) {
+            for (int attempt = 0; attempt != 30; ++attempt) {
+                const std::string lhs = randomString(size, symbol);
+                std::string rhs = lhs;
+                randomEdits(engine, rhs, attempt % 6, symbol);
+
+                const auto distance = editDistanceSlow(lhs, rhs);
+                for (unsigned k = 0; k != 6; ++k) {
+                    EXPECT_EQ(withinEditDistance(lhs, rhs, k), distance <= k)
+                        << lhs << " vs " << rhs << " k=" << k << " " << toString(oneChangeAutoLevel());
+                }
+            }
+        }
+    }
+}
+
+TEST(EditDistance, WithinLargeK) {
+    std::mt19937 engine(43);
+    const auto symbol = [&engine]() { return static_cast<char>('a' + engine() % 3); };
+
+    for (auto forced : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        const ForcedLevel forcedLevel(forced);
+        // cores over 64 bytes take the wave path, above k = 8 its waves are on the heap
+        for (size_t size : {65, 100, 150}) {
+            for (int attempt = 0; attempt != 10; ++attempt) {
+                const std::string lhs = randomString(size, symbol);
+                std::string rhs = lhs;
+                rhs.front() = '#';
+                rhs.back() = '#';
+                randomEdits(engine, rhs, 5 + attempt * 3, symbol);
+
+                const auto distance = editDistanceSlow(lhs, rhs);
+                for (unsigned k : {9u, 20u, 40u, 100u, 149u, 150u, 151u, 1000u, 4000000000u}) {
+                    EXPECT_EQ(withinEditDistance(lhs, rhs, k), distance <= k)
+                        << lhs << " vs " << rhs << " k=" << k << " " << toString(oneChangeAutoLevel());
+                    EXPECT_EQ(withinEditDistance(rhs, lhs, k), distance <= k);
+                }
+            }
+        }
+    }
+}
 
 void printInBinary(unsigned int num) {
     std::bitset<32> binary(num);  // assuming 32-bit unsigned int
@@ -0,0 +1,65 @@
+#include <type_traits>
+#include <utility>
+
+#include "fn.h"
+#include "kernels.h"
+
+
+// One-edit check over 16/32-bit elements. The scans are the byte kernels' vector traits compared per element,
+// see oneEditWide() in fn.cpp.
+template <typename T>
+static OneChangeResult oneChangeDetailWideT(std::span<const T> lhs, std::span<const T> rhs) noexcept {
+    const bool swapped = lhs.size() < rhs.size();
+    if (swapped) {
+        std::swap(lhs, rhs);
+    }
+    if (lhs.size() - rhs.size() > 1) {
+        return {OneChangeKind::None, 0};
+    }
+
+    const bool extra = lhs.size() != rhs.size();
+    auto result = oneEditWide(oneChangeAutoLevel(), lhs.data(), rhs.data(), rhs.size(), extra);
+    if (swapped && result.kind == OneChangeKind::Delete) {
+        result.kind = OneChangeKind::Insert;
+    }
+    return result;
+}
+
+// char16_t/char32_t as the unsigned integers of their size, the kernels only compare bytes
+template <typename T>
+static auto toSpan(std::basic_string_view<T> str) noexcept {
+    using Unsigned = std::conditional_t<sizeof(T) == 2, uint16_t, uint32_t>;
+    return std::span<const Unsigned>{reinterpret_cast<Unsigned const*>(str.data()), str.size()};
+}
+
+OneChangeResult oneChangeDetailWide(std::span<const uint16_t> lhs, std::span<const uint16_t> rhs) noexcept {
+    return oneChangeDetailWideT(lhs, rhs);
+}
+
+OneChangeResult oneChangeDetailWide(std::span<const uint32_t> lhs, std::span<const uint32_t> rhs) noexcept {
+    return oneChangeDetailWideT(lhs, rhs);
+}
+
+OneChangeResult oneChangeDetailWide(std::u16string_view lhs, std::u16string_view rhs) noexcept {
+    return oneChangeDetailWideT(toSpan(lhs), toSpan(rhs));
+}
+
+OneChangeResult oneChangeDetailWide(std::u32string_view lhs, std::u32string_view rhs) noexcept {
+    return oneChangeDetailWideT(toSpan(lhs), toSpan(rhs));
+}
+
+bool oneChangeWide(std::span<const uint16_t> lhs, std::span<const uint16_t> rhs) noexcept {
+    return oneChangeDetailWide(lhs, rhs).kind != OneChangeKind::None;
+}
+
+bool oneChangeWide(std::span<const uint32_t> lhs, std::span<const uint32_t> rhs) noexcept {
+    return oneChangeDetailWide(lhs, rhs).kind != OneChangeKind::None;
+}
+
+bool oneChangeWide(std::u16string_view lhs, std::u16string_view rhs) noexcept {
+    return oneChangeDetailWide(lhs, rhs).kind != OneChangeKind::None;
+}
+
+bool oneChangeWide(std::u32string_view lhs, std::u32string_view rhs) noexcept {
+    return oneChangeDetailWide(lhs, rhs).kind != OneChangeKind::None;
+}
@@ -0,0 +1,193 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+
+IntDistribution IntDistribution::fixed(size_t value) {
+    return uniform(value, value);
+}
+
+IntDistribution IntDistribution::uniform(size_t min, size_t max) {
+    IntDistribution result;
+    result.m_values = {min, std::max(min, max)};
+    result.m_description = min >= max ? std::to_string(min)
+                                      : "uniform(" + std::to_string(min) + ", " + std::to_string(max) + ")";
+    return result;
+}
+
+IntDistribution IntDistribution::histogram(std::vector<std::pair<size_t, double>> bins) {
+    IntDistribution result;
+    std::vector<double> weights;
+    std::ostringstream description;
+    for (auto [value, weight] : bins) {
+        if (weight > 0) {
+            result.m_values.push_back(value);
+            weights.push_back(weight);
+            description << (weights.size() == 1 ? "histogram(" : " ") << value << ":" << weight;
+        }
+    }
+    if (result.m_values.empty()) {
+        throw std::runtime_error("histogram without bins");
+    }
+    result.m_description = description.str() + ")";
+    result.m_bins = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    result.m_uniform = false;
+    return result;
+}
+
+IntDistribution IntDistribution::histogramFile(std::string const& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("can't read histogram " + path);
+    }
+
+    std::vector<std::pair<size_t, double>> bins;
+    std::string line;
+    while (std::getline(file, line)) {
+        line.erase(std::min(line.find('#'), line.size()));
+        std::istringstream fields(line);
+        size_t value = 0;
+        double weight = 1;
+        if (fields >> value) {
+            fields >> weight;
+            bins.emplace_back(value, weight);
+        }
+    }
+    auto result = histogram(std::move(bins));
+    result.m_description = "histogram(" + path + ")";
+    return result;
+}
+
+size_t IntDistribution::operator()(std::mt19937_64& engine) const {
+    if (m_uniform) {
+        return std::uniform_int_distribution<size_t>(m_values[0], m_values[1])(engine);
+    }
+    return m_values[m_bins(engine)];
+}
+
+
+namespace {
+
+constexpr std::string_view ALPHABET = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+char randomChar(std::mt19937_64& engine) {
+    return ALPHABET[engine() % ALPHABET.size()];
+}
+
+char otherChar(char c, std::mt19937_64& engine) {
+    char result = randomChar(engine);
+    while (result == c) {
+        result = randomChar(engine);
+    }
+    return result;
+}
+
+// position of the edit in a string of `size` bytes, `end` allows the position past the last byte (insert)
+size_t editPosition(WorkloadConfig const& config, size_t size, bool end, std::mt19937_64& engine) {
+    const auto position = std::min<size_t>(config.editPercent(engine), 100) * size / 100;
+    return end ? position : std::min(position, size - 1);
+}
+
+void applyOneEdit(WorkloadConfig const& config, std::string& str, std::mt19937_64& engine) {
+    const auto kind = str.empty() ? 0 : engine() % 3;
+    const auto pos = editPosition(config, str.size(), kind == 0, engine);
+    switch (kind) {
+        case 0: str.insert(pos, 1, randomChar(engine)); break;
+        case 1: str.erase(pos, 1); break;
+        default: str[pos] = otherChar(str[pos], engine);
+    }
+}
+
+// two replaces at different positions, or 2..3 bytes inserted/deleted at one position
+void applyFarEdit(WorkloadConfig const& config, std::string& str, std::mt19937_64& engine) {
+    if (str.size() >= 2 && engine() % 2 == 0) {
+        const auto first = editPosition(config, str.size(), false, engine);
+        auto second = std::uniform_int_distribution<size_t>(0, str.size() - 2)(engine);
+        second += second >= first;
+        str[first] = otherChar(str[first], engine);
+        str[second] = otherChar(str[second], engine);
+        return;
+    }
+
+    const size_t count = 2 + engine() % 2;
+    if (str.size() >= count && engine() % 2 == 0) {
+        str.erase(std::min(editPosition(config, str.size(), false, engine), str.size() - count), count);
+    } else {
+        const auto pos = editPosition(config, str.size(), true, engine);
+        for (size_t i = 0; i != count; ++i) {
+            str.insert(pos, 1, randomChar(engine));
+        }
+    }
+}
+
+} // namespace
+
+
+Workload::Workload(WorkloadConfig const& config, size_t poolBytes) {
+    std::mt19937_64 engine(config.seed);
+    const double total = config.equal + config.oneEdit + config.far;
+    std::uniform_real_distribution<double> share(0, total > 0 ? total : 1);
+
+    // lhs and rhs of a pair are adjacent in the arena, offsets become views once the arena stops growing
+    struct Offsets {
+        size_t lhs;
+        size_t lhsSize;
+        size_t rhsSize;
+        bool oneChange;
+    };
+    std::vector<Offsets> offsets;
+    std::string lhs;
+    std::string rhs;
+    m_arena.reserve(poolBytes);
+    while (m_arena.size() < poolBytes || offsets.empty()) {
+        lhs.resize(config.length(engine));
+        for (auto& c : lhs) {
+            c = randomChar(engine);
+        }
+        rhs = lhs;
+
+        const auto pick = share(engine);
+        bool oneChange = true;
+        if (pick >= config.equal && pick < config.equal + config.oneEdit) {
+            applyOneEdit(config, rhs, engine);
+        } else if (pick >= config.equal + config.oneEdit) {
+            applyFarEdit(config, rhs, engine);
+            oneChange = false;
+        }
+
+        offsets.push_back({m_arena.size(), lhs.size(), rhs.size(), oneChange});
+        m_arena += lhs;
+        m_arena += rhs;
+    }
+
+    m_pairs.reserve(offsets.size());
+    for (auto const& pair : offsets) {
+        const std::string_view lhsView(m_arena.data() + pair.lhs, pair.lhsSize);
+        const std::string_view rhsView(lhsView.data() + pair.lhsSize, pair.rhsSize);
+        m_pairs.push_back({lhsView, rhsView, pair.oneChange});
+    }
+    std::shuffle(m_pairs.begin(), m_pairs.end(), engine);
+}
+
+std::string toJson(WorkloadConfig const& config) {
+    std::ostringstream json;
+    json << R"({"name": ")" << config.name << R"(", "length": ")" << config.length.description()
+         << R"(", "editPercent": ")" << config.editPercent.description() << R"(", "equal": )" << config.equal
+         << R"(, "oneEdit": )" << config.oneEdit << R"(, "far": )" << config.far << R"(, "seed": )" << config.seed
+         << "}";
+    return json.str();
+}
+
+size_t lastLevelCacheSize() noexcept {
+    for (int level : {_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE}) {
+        if (const auto size = sysconf(level); size > 0) {
+            return static_cast<size_t>(size);
+        }
+    }
+    return 32 << 20;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+// Benchmark workloads: pools of distinct string pairs with lengths, edit positions and the mix of
+// equal / one-edit / far pairs drawn from configurable distributions (bench target only).
+
+// Distribution of non-negative integers: a fixed value, uniform in [min, max] or a weighted histogram
+class IntDistribution {
+public:
+    static IntDistribution fixed(size_t value);
+    static IntDistribution uniform(size_t min, size_t max);
+    static IntDistribution histogram(std::vector<std::pair<size_t, double>> bins);
+    // Text file with one "value weight" bin per line (weight 1 if omitted), '#' starts a comment.
+    // Throws std::runtime_error if the file can't be read or has no bins
+    static IntDistribution histogramFile(std::string const& path);
+
+    size_t operator()(std::mt19937_64& engine) const;
+    std::string const& description() const noexcept {
+        return m_description;
+    }
+
+private:
+    std::vector<size_t> m_values; // uniform: {min, max}
+    mutable std::discrete_distribution<size_t> m_bins; // histogram: index into m_values
+    bool m_uniform = true;
+    std::string m_description;
+};
+
+struct WorkloadConfig {
+    std::string name;
+    IntDistribution length = IntDistribution::uniform(4, 64);
+    // Where the edit is, in percent of the length: 0 is the first byte, 100 is past the end
+    IntDistribution editPercent = IntDistribution::uniform(0, 100);
+    // Shares of equal pairs, pairs one replace/insert/delete apart and far pairs (two replaces or
+    // sizes that differ by 2+), normalized by their sum
+    double equal = 0.2;
+    double oneEdit = 0.4;
+    double far = 0.4;
+    uint64_t seed = 42;
+};
+
+struct WorkloadPair {
+    std::string_view lhs;
+    std::string_view rhs;
+    bool oneChange; // the expected verdict
+};
+
+// Distinct pairs with about poolBytes bytes of strings in one arena. The strings are placed in a shuffled
+// order, so going over pairs() in order touches the arena at random: a pool much larger than the last
+// level cache measures cache-cold calls, a pool in L2 the warm ones.
+class Workload {
+public:
+    Workload(WorkloadConfig const& config, size_t poolBytes);
+
+    std::span<const WorkloadPair> pairs() const noexcept {
+        return m_pairs;
+    }
+
+    size_t bytes() const noexcept {
+        return m_arena.size();
+    }
+
+private:
+    std::string m_arena;
+    std::vector<WorkloadPair> m_pairs;
+};
+
+// JSON object with the config, for the context of benchmark reports
+std::string toJson(WorkloadConfig const& config);
+
+// Size of the last level data cache, 32 MiB if it isn't known
+size_t lastLevelCacheSize() noexcept;